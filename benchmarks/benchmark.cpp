@@ -0,0 +1,276 @@
+#include "benchmark.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+namespace bench
+{
+    static std::vector<benchmark> &registry()
+    {
+        static std::vector<benchmark> benchmarks;
+        return benchmarks;
+    }
+
+    void add(benchmark b) { registry().push_back(std::move(b)); }
+
+    struct options
+    {
+        std::string filter;       // only the benchmarks whose name contains the filter are run..
+        size_t warmup = 2;        // the number of unmeasured repetitions..
+        size_t repetitions = 10;  // the number of measured repetitions..
+        double min_time = 0.01;   // the minimum duration, in seconds, of each repetition..
+        std::string json;         // the file the results are written to, `-` for the standard output..
+        std::string baseline;     // the file of the results to compare with..
+    };
+
+    struct result
+    {
+        std::string name;
+        size_t size;
+        size_t iterations;  // the number of runs of the body in each repetition..
+        size_t repetitions;
+        double min_ns, max_ns, mean_ns, median_ns, stddev_ns; // the statistics of the duration of a run of the body..
+        double items_per_second;                              // zero, if the throughput is not meaningful..
+        std::string unit;
+    };
+
+    static double seconds(const body &f, size_t iterations)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i)
+            f();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count();
+    }
+
+    static result run(const benchmark &b, size_t size, const options &opts)
+    {
+        const body f = b.setup(size);
+
+        // we calibrate the number of runs of the body, so that each repetition lasts at least `min_time`..
+        size_t iterations = 1;
+        for (double t = seconds(f, iterations); t < opts.min_time && iterations < (size_t(1) << 30);)
+        {
+            const double scale = t > 0 ? std::min(10.0, 1.5 * opts.min_time / t) : 10.0;
+            iterations = std::max(iterations + 1, static_cast<size_t>(iterations * scale));
+            t = seconds(f, iterations);
+        }
+
+        for (size_t r = 0; r < opts.warmup; ++r)
+            seconds(f, iterations);
+
+        std::vector<double> samples(opts.repetitions);
+        for (auto &s : samples)
+            s = seconds(f, iterations) * 1e9 / iterations;
+
+        result res{b.name, size, iterations, opts.repetitions, 0, 0, 0, 0, 0, 0, b.unit};
+        std::sort(samples.begin(), samples.end());
+        res.min_ns = samples.front();
+        res.max_ns = samples.back();
+        res.median_ns = samples.size() % 2 ? samples[samples.size() / 2] : (samples[samples.size() / 2 - 1] + samples[samples.size() / 2]) / 2;
+        for (const auto s : samples)
+            res.mean_ns += s;
+        res.mean_ns /= samples.size();
+        for (const auto s : samples)
+            res.stddev_ns += (s - res.mean_ns) * (s - res.mean_ns);
+        res.stddev_ns = samples.size() > 1 ? std::sqrt(res.stddev_ns / (samples.size() - 1)) : 0;
+        if (b.items)
+            res.items_per_second = b.items(size) * 1e9 / res.median_ns;
+        return res;
+    }
+
+    static std::string format_ns(double ns)
+    {
+        std::ostringstream os;
+        os << std::fixed << std::setprecision(ns < 10 ? 2 : 1);
+        if (ns < 1e3)
+            os << ns << " ns";
+        else if (ns < 1e6)
+            os << ns / 1e3 << " us";
+        else if (ns < 1e9)
+            os << ns / 1e6 << " ms";
+        else
+            os << ns / 1e9 << " s";
+        return os.str();
+    }
+
+    static std::string format_rate(double rate, const std::string &unit)
+    {
+        if (rate <= 0)
+            return "";
+        std::ostringstream os;
+        os << std::fixed << std::setprecision(2);
+        if (unit == "bytes")
+        {
+            if (rate >= double(1 << 30))
+                os << rate / (1 << 30) << " GiB/s";
+            else
+                os << rate / (1 << 20) << " MiB/s";
+        }
+        else if (rate >= 1e9)
+            os << rate / 1e9 << " G" << unit << "/s";
+        else if (rate >= 1e6)
+            os << rate / 1e6 << " M" << unit << "/s";
+        else
+            os << rate / 1e3 << " k" << unit << "/s";
+        return os.str();
+    }
+
+    static std::string key(const std::string &name, size_t size) { return name + '/' + std::to_string(size); }
+
+    /**
+     * @brief Reads the median durations of a JSON file written by `write_json`, one benchmark per line.
+     */
+    static std::map<std::string, double> read_baseline(const std::string &file)
+    {
+        std::map<std::string, double> medians;
+        std::ifstream in(file);
+        if (!in)
+        {
+            std::cerr << "cannot read the baseline " << file << '\n';
+            return medians;
+        }
+        const auto field = [](const std::string &line, const char *name) -> std::string
+        {
+            const std::string tag = std::string("\"") + name + "\": ";
+            const auto pos = line.find(tag);
+            if (pos == std::string::npos)
+                return "";
+            auto begin = pos + tag.size();
+            if (line[begin] == '"')
+                return line.substr(begin + 1, line.find('"', begin + 1) - begin - 1);
+            return line.substr(begin, line.find_first_of(",}", begin) - begin);
+        };
+        for (std::string line; std::getline(in, line);)
+        {
+            const auto name = field(line, "name"), size = field(line, "size"), median = field(line, "median_ns");
+            if (!name.empty() && !size.empty() && !median.empty())
+                try
+                {
+                    medians[key(name, std::stoull(size))] = std::stod(median);
+                }
+                catch (const std::logic_error &) // a malformed line is skipped..
+                {
+                }
+        }
+        return medians;
+    }
+
+    static void write_json(std::ostream &os, const std::vector<result> &results, const options &opts)
+    {
+        os << "{\n  \"context\": {\"warmup\": " << opts.warmup << ", \"repetitions\": " << opts.repetitions << ", \"min_time\": " << opts.min_time
+#ifdef NDEBUG
+           << ", \"assertions\": false"
+#else
+           << ", \"assertions\": true"
+#endif
+           << "},\n  \"benchmarks\": [\n";
+        os << std::setprecision(6);
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            const auto &r = results[i];
+            os << "    {\"name\": \"" << r.name << "\", \"size\": " << r.size << ", \"iterations\": " << r.iterations << ", \"repetitions\": " << r.repetitions
+               << ", \"min_ns\": " << r.min_ns << ", \"max_ns\": " << r.max_ns << ", \"mean_ns\": " << r.mean_ns << ", \"median_ns\": " << r.median_ns << ", \"stddev_ns\": " << r.stddev_ns
+               << ", \"items_per_second\": " << r.items_per_second << ", \"unit\": \"" << r.unit << "\"}" << (i + 1 < results.size() ? ",\n" : "\n");
+        }
+        os << "  ]\n}\n";
+    }
+
+    static void usage(const char *program)
+    {
+        std::cerr << "usage: " << program << " [--filter <text>] [--warmup <n>] [--repetitions <n>] [--min-time <seconds>] [--json <file>|-] [--baseline <file>] [--list]\n";
+    }
+} // namespace bench
+
+int main(int argc, char *argv[])
+{
+    bench::register_numeric_benchmarks();
+    bench::register_search_benchmarks();
+    bench::register_codec_benchmarks();
+#ifdef UTILS_ENABLE_CRYPTO
+    bench::register_crypto_benchmarks();
+#endif
+
+    bench::options opts;
+    bool list = false;
+    try
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            const std::string arg = argv[i];
+            const bool has_value = i + 1 < argc;
+            if (arg == "--filter" && has_value)
+                opts.filter = argv[++i];
+            else if (arg == "--warmup" && has_value)
+                opts.warmup = std::stoul(argv[++i]);
+            else if (arg == "--repetitions" && has_value)
+                opts.repetitions = std::max<size_t>(1, std::stoul(argv[++i]));
+            else if (arg == "--min-time" && has_value)
+                opts.min_time = std::stod(argv[++i]);
+            else if (arg == "--json" && has_value)
+                opts.json = argv[++i];
+            else if (arg == "--baseline" && has_value)
+                opts.baseline = argv[++i];
+            else if (arg == "--list")
+                list = true;
+            else
+            {
+                bench::usage(argv[0]);
+                return 1;
+            }
+        }
+    }
+    catch (const std::logic_error &) // std::invalid_argument or std::out_of_range, from a malformed number..
+    {
+        bench::usage(argv[0]);
+        return 1;
+    }
+
+    const auto baseline = opts.baseline.empty() ? std::map<std::string, double>() : bench::read_baseline(opts.baseline);
+    std::ostream &out = opts.json == "-" ? std::cerr : std::cout; // the human-readable report does not mix with the JSON output..
+    std::vector<bench::result> results;
+    for (const auto &b : bench::registry())
+    {
+        if (b.name.find(opts.filter) == std::string::npos)
+            continue;
+        for (const auto size : b.sizes)
+        {
+            if (list)
+            {
+                out << bench::key(b.name, size) << '\n';
+                continue;
+            }
+            const auto r = bench::run(b, size, opts);
+            out << std::left << std::setw(36) << bench::key(r.name, r.size) << std::right
+                << std::setw(12) << bench::format_ns(r.median_ns) << " (+/- " << std::fixed << std::setprecision(1) << (r.mean_ns > 0 ? 100 * r.stddev_ns / r.mean_ns : 0) << "%)"
+                << "  " << std::setw(22) << bench::format_rate(r.items_per_second, r.unit);
+            if (const auto it = baseline.find(bench::key(r.name, r.size)); it != baseline.end())
+                out << "  " << std::showpos << std::setprecision(1) << 100 * (r.median_ns / it->second - 1) << "%" << std::noshowpos << " vs baseline";
+            out << std::endl;
+            results.push_back(r);
+        }
+    }
+
+    if (!opts.json.empty() && !list)
+    {
+        if (opts.json == "-")
+            bench::write_json(std::cout, results, opts);
+        else
+        {
+            std::ofstream file(opts.json);
+            if (!file)
+            {
+                std::cerr << "cannot write " << opts.json << '\n';
+                return 1;
+            }
+            bench::write_json(file, results, opts);
+        }
+    }
+    return 0;
+}
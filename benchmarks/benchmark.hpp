@@ -0,0 +1,51 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace bench
+{
+    /**
+     * @brief The code being measured, built by the setup of a benchmark for a given input size.
+     */
+    using body = std::function<void()>;
+
+    /**
+     * @brief A benchmark, run once for each of its input sizes.
+     */
+    struct benchmark
+    {
+        std::string name;                          // the name of the benchmark..
+        std::vector<size_t> sizes;                 // the input sizes..
+        std::function<body(size_t)> setup;         // builds, out of the measurement, the input of the given size and returns the body to measure..
+        std::function<double(size_t)> items;       // the number of items processed by a run of the body of the given size, if the throughput is meaningful..
+        std::string unit = "items";                // the unit of the items (e.g., bytes)..
+    };
+
+    /**
+     * @brief Registers a benchmark.
+     */
+    void add(benchmark b);
+
+    /**
+     * @brief Prevents the compiler from optimizing away the computation of `value`.
+     */
+    template <typename T>
+    inline void keep(const T &value) noexcept
+    {
+#ifdef _MSC_VER
+        static volatile const void *sink;
+        sink = &value;
+#else
+        asm volatile("" : : "r"(&value) : "memory");
+#endif
+    }
+
+    void register_numeric_benchmarks();
+    void register_search_benchmarks();
+    void register_codec_benchmarks();
+#ifdef UTILS_ENABLE_CRYPTO
+    void register_crypto_benchmarks();
+#endif
+} // namespace bench
@@ -0,0 +1,109 @@
+#include "benchmark.hpp"
+#include "sha1.hpp"
+#include "base64.hpp"
+#include <memory>
+
+namespace bench
+{
+    static std::shared_ptr<std::vector<unsigned char>> random_bytes(size_t n)
+    {
+        auto data = std::make_shared<std::vector<unsigned char>>(n);
+        for (size_t i = 0; i < n; ++i)
+            (*data)[i] = static_cast<unsigned char>(i * 131 + (i >> 11));
+        return data;
+    }
+
+    static double bytes(size_t n) { return static_cast<double>(n); }
+
+    static void register_sha1()
+    {
+        const std::pair<utils::sha1_backend, const char *> backends[] = {{utils::sha1_backend::portable, "portable"}, {utils::sha1_backend::ssse3, "ssse3"}, {utils::sha1_backend::sha_ni, "sha_ni"}};
+        for (const auto &[backend, name] : backends)
+        {
+            const auto compress = utils::get_sha1_compress(backend);
+            if (!compress)
+                continue; // not supported by the CPU..
+            add({std::string("sha1/") + name, {64, 4 << 10, 1 << 20}, [compress](size_t n) -> body
+                 {
+                     auto data = random_bytes(n);
+                     return [data, compress, n]()
+                     {
+                         unsigned int state[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+                         compress(state, data->data(), n / 64);
+                         keep(state);
+                     };
+                 },
+                 bytes, "bytes"});
+        }
+
+        // many independent 100-byte messages, hashed one per SIMD lane..
+        const std::pair<utils::sha1_batch_backend, const char *> batch_backends[] = {{utils::sha1_batch_backend::serial, "serial"}, {utils::sha1_batch_backend::avx2, "avx2"}, {utils::sha1_batch_backend::avx512, "avx512"}};
+        for (const auto &[backend, name] : batch_backends)
+        {
+            const auto batch = utils::get_sha1_batch(backend);
+            if (!batch)
+                continue;
+            add({std::string("sha1_batch/") + name, {64, 4096}, [batch](size_t n) -> body
+                 {
+                     constexpr size_t message_size = 100;
+                     auto data = random_bytes(n * message_size);
+                     auto messages = std::make_shared<std::vector<std::string_view>>();
+                     for (size_t i = 0; i < n; ++i)
+                         messages->emplace_back(reinterpret_cast<const char *>(data->data()) + i * message_size, message_size);
+                     auto digests = std::make_shared<std::vector<utils::sha1::digest_8>>(n);
+                     return [data, messages, digests, batch]()
+                     {
+                         batch(messages->data(), messages->size(), digests->data());
+                         keep(*digests);
+                     };
+                 },
+                 [](size_t n)
+                 { return static_cast<double>(n); },
+                 "messages"});
+        }
+    }
+
+    static void register_base64()
+    {
+        const std::pair<utils::base64_backend, const char *> backends[] = {{utils::base64_backend::portable, "portable"}, {utils::base64_backend::ssse3, "ssse3"}, {utils::base64_backend::avx2, "avx2"}};
+        const auto selected = utils::get_base64_backend();
+        for (const auto &[backend, name] : backends)
+        {
+            if (!utils::set_base64_backend(backend))
+                continue; // not supported by the CPU..
+            add({std::string("base64_encode/") + name, {64, 4 << 10, 1 << 20}, [backend = backend](size_t n) -> body
+                 {
+                     utils::set_base64_backend(backend); // the benchmarks run one after the other..
+                     auto data = random_bytes(n);
+                     auto encoded = std::make_shared<std::vector<char>>(utils::base64_encoded_size(n));
+                     return [data, encoded, n]()
+                     {
+                         utils::base64_encode(data->data(), n, encoded->data());
+                         keep(*encoded);
+                     };
+                 },
+                 bytes, "bytes"});
+            add({std::string("base64_decode/") + name, {64, 4 << 10, 1 << 20}, [backend = backend](size_t n) -> body
+                 {
+                     utils::set_base64_backend(backend); // the benchmarks run one after the other..
+                     auto data = random_bytes(n);
+                     auto encoded = std::make_shared<std::vector<char>>(utils::base64_encoded_size(n));
+                     utils::base64_encode(data->data(), n, encoded->data());
+                     auto decoded = std::make_shared<std::vector<unsigned char>>(utils::base64_decoded_max_size(encoded->size()));
+                     return [encoded, decoded]()
+                     {
+                         const size_t len = utils::base64_decode(encoded->data(), encoded->size(), decoded->data());
+                         keep(len);
+                     };
+                 },
+                 bytes, "bytes"});
+        }
+        utils::set_base64_backend(selected);
+    }
+
+    void register_codec_benchmarks()
+    {
+        register_sha1();
+        register_base64();
+    }
+} // namespace bench
@@ -0,0 +1,86 @@
+#include "benchmark.hpp"
+#include "crypto.hpp"
+#include <memory>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/rsa.h>
+
+namespace bench
+{
+    static std::string generate_private_key()
+    {
+        EVP_PKEY *pkey = EVP_RSA_gen(2048);
+        BIO *bio = BIO_new(BIO_s_mem());
+        PEM_write_bio_PrivateKey(bio, pkey, nullptr, nullptr, 0, nullptr, nullptr);
+        char *pem_data;
+        long pem_len = BIO_get_mem_data(bio, &pem_data);
+        std::string pem(pem_data, pem_len);
+        BIO_free(bio);
+        EVP_PKEY_free(pkey);
+        return pem;
+    }
+
+    static const std::string &private_key()
+    {
+        static const std::string key = generate_private_key();
+        return key;
+    }
+
+    static const std::string payload = "eyJhbGciOiJSUzI1NiIsInR5cCI6IkpXVCJ9.eyJzdWIiOiIxMjM0NTY3ODkwIiwibmFtZSI6IkpvaG4gRG9lIiwiaWF0IjoxNTE2MjM5MDIyfQ";
+
+    void register_crypto_benchmarks()
+    {
+        const auto items = [](size_t n)
+        { return static_cast<double>(n); };
+        add({"rs256/sign_parsing_key", {1}, [](size_t) -> body
+             {
+                 return []()
+                 { keep(utils::rs256_signer(private_key()).sign(payload)); };
+             },
+             items, "signatures"});
+        add({"rs256/sign", {1, 64}, [](size_t n) -> body
+             {
+                 auto signer = std::make_shared<const utils::rs256_signer>(private_key());
+                 auto batch = std::make_shared<const std::vector<std::string_view>>(n, payload);
+                 if (n == 1)
+                     return [signer]()
+                     { keep(signer->sign(payload)); };
+                 return [signer, batch]()
+                 { keep(signer->sign(*batch)); };
+             },
+             items, "signatures"});
+        add({"rs256/verify_parsing_key", {1}, [](size_t) -> body
+             {
+                 auto public_key = std::make_shared<const std::string>(utils::extract_public_key(private_key()));
+                 auto signature = std::make_shared<const std::string>(utils::rs256_signer(private_key()).sign(payload));
+                 return [public_key, signature]()
+                 {
+                     utils::rs256_verifier v;
+                     v.add_key("k", *public_key);
+                     keep(v.verify("k", payload, *signature));
+                 };
+             },
+             items, "verifications"});
+        add({"rs256/verify", {1, 64}, [](size_t n) -> body
+             {
+                 auto verifier = std::make_shared<utils::rs256_verifier>();
+                 verifier->add_key("k", utils::extract_public_key(private_key()));
+                 auto signature = std::make_shared<const std::string>(utils::rs256_signer(private_key()).sign(payload));
+                 auto tokens = std::make_shared<const std::vector<utils::rs256_token>>(n, utils::rs256_token{"k", payload, *signature});
+                 if (n == 1)
+                     return [verifier, signature]()
+                     { keep(verifier->verify("k", payload, *signature)); };
+                 return [verifier, tokens]()
+                 { keep(verifier->verify(*tokens)); };
+             },
+             items, "verifications"});
+        add({"password/encode", {1000, 10000}, [](size_t iterations) -> body
+             {
+                 return [iterations]()
+                 { keep(utils::encode_password("correct horse battery staple", "0123456789abcdef", static_cast<int>(iterations))); };
+             },
+             [](size_t)
+             { return 1.0; },
+             "hashes"});
+    }
+} // namespace bench
@@ -0,0 +1,201 @@
+#include "benchmark.hpp"
+#include "rational.hpp"
+#include "lin.hpp"
+#include "tableau.hpp"
+#include "matrix.hpp"
+#include "loss.hpp"
+#include <memory>
+#include <random>
+
+namespace bench
+{
+    static std::vector<utils::rational> random_rationals(size_t n, unsigned seed)
+    {
+        std::mt19937 gen(seed);
+        std::uniform_int_distribution<INT_TYPE> num(-1000, 1000), den(1, 1000);
+        std::vector<utils::rational> rs;
+        rs.reserve(n);
+        for (size_t i = 0; i < n; ++i)
+            rs.emplace_back(num(gen), den(gen));
+        return rs;
+    }
+
+    static void register_rational()
+    {
+        const auto items = [](size_t n)
+        { return static_cast<double>(n); };
+        add({"rational/add", {1 << 10, 1 << 16}, [](size_t n) -> body
+             {
+                 auto a = std::make_shared<std::vector<utils::rational>>(random_rationals(n, 1));
+                 auto b = std::make_shared<std::vector<utils::rational>>(random_rationals(n, 2));
+                 auto c = std::make_shared<std::vector<utils::rational>>(n);
+                 return [a, b, c, n]()
+                 {
+                     for (size_t i = 0; i < n; ++i)
+                         (*c)[i] = (*a)[i] + (*b)[i];
+                     keep(*c);
+                 };
+             },
+             items, "ops"});
+        add({"rational/mul", {1 << 10, 1 << 16}, [](size_t n) -> body
+             {
+                 auto a = std::make_shared<std::vector<utils::rational>>(random_rationals(n, 3));
+                 auto b = std::make_shared<std::vector<utils::rational>>(random_rationals(n, 4));
+                 auto c = std::make_shared<std::vector<utils::rational>>(n);
+                 return [a, b, c, n]()
+                 {
+                     for (size_t i = 0; i < n; ++i)
+                         (*c)[i] = (*a)[i] * (*b)[i];
+                     keep(*c);
+                 };
+             },
+             items, "ops"});
+        add({"rational/compare", {1 << 10, 1 << 16}, [](size_t n) -> body
+             {
+                 auto a = std::make_shared<std::vector<utils::rational>>(random_rationals(n, 5));
+                 auto b = std::make_shared<std::vector<utils::rational>>(random_rationals(n, 6));
+                 return [a, b, n]()
+                 {
+                     size_t less = 0;
+                     for (size_t i = 0; i < n; ++i)
+                         less += (*a)[i] < (*b)[i];
+                     keep(less);
+                 };
+             },
+             items, "ops"});
+    }
+
+    static utils::lin random_lin(size_t n_vars, size_t stride, unsigned seed)
+    {
+        const auto coefficients = random_rationals(n_vars, seed);
+        utils::lin l;
+        for (size_t i = 0; i < n_vars; ++i)
+            l += utils::lin(i * stride, coefficients[i]);
+        return l;
+    }
+
+    static void register_lin()
+    {
+        // the second expression shares half of its variables with the first one..
+        add({"lin/add", {8, 64, 512}, [](size_t n) -> body
+             {
+                 auto a = std::make_shared<utils::lin>(random_lin(n, 2, 7));
+                 auto b = std::make_shared<utils::lin>(random_lin(n, 1, 8));
+                 return [a, b]()
+                 {
+                     utils::lin c = *a;
+                     c += *b;
+                     keep(c);
+                 };
+             },
+             [](size_t n)
+             { return static_cast<double>(n); },
+             "terms"});
+    }
+
+    static void register_tableau()
+    {
+        // `size` rows over 16 non-basic variables; each run pivots a basic variable out of the base and back in..
+        add({"tableau/pivot", {8, 32, 128}, [](size_t rows) -> body
+             {
+                 constexpr size_t n_vars = 16;
+                 auto t = std::make_shared<utils::tableau>();
+                 std::vector<utils::var> ys, xs;
+                 for (size_t i = 0; i < n_vars; ++i)
+                     ys.push_back(t->new_var());
+                 for (size_t i = 0; i < rows; ++i)
+                     xs.push_back(t->new_var());
+                 std::mt19937 gen(9);
+                 std::uniform_int_distribution<INT_TYPE> num(1, 9), den(1, 9);
+                 for (size_t i = 0; i < rows; ++i)
+                 {
+                     utils::lin l(utils::rational(num(gen), den(gen)));
+                     for (size_t j = 0; j < n_vars; ++j)
+                         if ((i + j) % 3 != 0)
+                             l += utils::lin(ys[j], utils::rational(num(gen), den(gen)));
+                     t->add_row(xs[i], std::move(l));
+                 }
+                 return [t, x = xs[0], y = ys[1]]()
+                 {
+                     t->pivot(x, y);
+                     t->pivot(y, x);
+                 };
+             },
+             [](size_t)
+             { return 2.0; },
+             "pivots"});
+    }
+
+    template <size_t N>
+    static body matmul_setup()
+    {
+        auto a = std::make_shared<utils::matrix<N, N, double>>();
+        auto b = std::make_shared<utils::matrix<N, N, double>>();
+        auto c = std::make_shared<utils::matrix<N, N, double>>();
+        std::mt19937 gen(10);
+        std::uniform_real_distribution<double> dist(-1, 1);
+        for (size_t i = 0; i < N; ++i)
+            for (size_t j = 0; j < N; ++j)
+            {
+                (*a)[i][j] = dist(gen);
+                (*b)[i][j] = dist(gen);
+            }
+        return [a, b, c]()
+        {
+            *c = utils::matmul(*a, *b);
+            keep(*c);
+        };
+    }
+
+    static void register_matmul()
+    {
+        add({"matmul", {16, 64, 128}, [](size_t n) -> body
+             {
+                 switch (n)
+                 {
+                 case 16:
+                     return matmul_setup<16>();
+                 case 64:
+                     return matmul_setup<64>();
+                 default:
+                     return matmul_setup<128>();
+                 }
+             },
+             [](size_t n)
+             { return 2.0 * n * n * n; },
+             "flop"});
+    }
+
+    static void register_mse()
+    {
+        add({"mse", {1 << 10, 1 << 16, 1 << 20}, [](size_t n) -> body
+             {
+                 auto y_true = std::make_shared<std::vector<double>>(n);
+                 auto y_pred = std::make_shared<std::vector<double>>(n);
+                 std::mt19937 gen(11);
+                 std::uniform_real_distribution<double> dist(-1, 1);
+                 for (size_t i = 0; i < n; ++i)
+                 {
+                     (*y_true)[i] = dist(gen);
+                     (*y_pred)[i] = dist(gen);
+                 }
+                 return [y_true, y_pred, n]()
+                 {
+                     const double err = utils::mse(y_true->data(), y_pred->data(), n);
+                     keep(err);
+                 };
+             },
+             [](size_t n)
+             { return static_cast<double>(n); },
+             "elements"});
+    }
+
+    void register_numeric_benchmarks()
+    {
+        register_rational();
+        register_lin();
+        register_tableau();
+        register_matmul();
+        register_mse();
+    }
+} // namespace bench
@@ -0,0 +1,114 @@
+#include "benchmark.hpp"
+#include "a_star.hpp"
+#include "floyd_warshall.hpp"
+#include <memory>
+#include <random>
+
+namespace bench
+{
+    /**
+     * @brief A cell of a square grid, whose heuristic is the Manhattan distance from the opposite corner.
+     */
+    class grid_node final : public utils::node<int>
+    {
+    public:
+        grid_node(size_t x, size_t y, size_t side) : x(x), y(y), side(side) {}
+
+        [[nodiscard]] int cost(std::shared_ptr<utils::node<int>> = nullptr) const noexcept override { return static_cast<int>((side - 1 - x) + (side - 1 - y)); }
+        [[nodiscard]] std::unordered_map<std::shared_ptr<utils::node<int>>, int> get_successors() override
+        {
+            std::unordered_map<std::shared_ptr<utils::node<int>>, int> successors;
+            successors.reserve(neighbors.size());
+            for (const auto &[n, c] : neighbors)
+                successors.emplace(n.lock(), c);
+            return successors;
+        }
+        [[nodiscard]] bool is_goal() const noexcept override { return x == side - 1 && y == side - 1; }
+
+        std::vector<std::pair<std::weak_ptr<grid_node>, int>> neighbors;
+
+    private:
+        const size_t x, y, side;
+    };
+
+    static void register_a_star()
+    {
+        // a `side` x `side` grid with random edge costs in [1, 4], searched from a corner to the opposite one..
+        add({"a_star/search", {16, 64, 128}, [](size_t side) -> body
+             {
+                 auto nodes = std::make_shared<std::vector<std::shared_ptr<grid_node>>>();
+                 for (size_t y = 0; y < side; ++y)
+                     for (size_t x = 0; x < side; ++x)
+                         nodes->push_back(std::make_shared<grid_node>(x, y, side));
+                 std::mt19937 gen(12);
+                 std::uniform_int_distribution<int> cost(1, 4);
+                 for (size_t y = 0; y < side; ++y)
+                     for (size_t x = 0; x < side; ++x)
+                     {
+                         auto &n = (*nodes)[y * side + x];
+                         if (x + 1 < side)
+                             n->neighbors.emplace_back((*nodes)[y * side + x + 1], cost(gen));
+                         if (y + 1 < side)
+                             n->neighbors.emplace_back((*nodes)[(y + 1) * side + x], cost(gen));
+                         if (x > 0)
+                             n->neighbors.emplace_back((*nodes)[y * side + x - 1], cost(gen));
+                         if (y > 0)
+                             n->neighbors.emplace_back((*nodes)[(y - 1) * side + x], cost(gen));
+                     }
+                 return [nodes]()
+                 {
+                     utils::a_star<int> solver(nodes->front());
+                     auto goal = solver.search();
+                     keep(goal);
+                 };
+             },
+             [](size_t side)
+             { return static_cast<double>(side * side); },
+             "nodes"});
+    }
+
+    template <size_t N>
+    static body floyd_warshall_setup()
+    {
+        auto graph = std::make_shared<utils::floyd_warshall<double, N>>();
+        auto work = std::make_shared<utils::floyd_warshall<double, N>>();
+        std::mt19937 gen(13);
+        std::uniform_real_distribution<double> weight(1, 10);
+        std::bernoulli_distribution edge(0.1);
+        for (size_t u = 0; u < N; ++u)
+            for (size_t v = 0; v < N; ++v)
+                if (u != v && edge(gen))
+                    graph->add_edge(u, v, weight(gen));
+        return [graph, work]()
+        {
+            *work = *graph;
+            work->compute_all_pairs_shortest_paths();
+            keep(*work);
+        };
+    }
+
+    static void register_floyd_warshall()
+    {
+        add({"floyd_warshall/all_pairs", {32, 128, 256}, [](size_t n) -> body
+             {
+                 switch (n)
+                 {
+                 case 32:
+                     return floyd_warshall_setup<32>();
+                 case 128:
+                     return floyd_warshall_setup<128>();
+                 default:
+                     return floyd_warshall_setup<256>();
+                 }
+             },
+             [](size_t n)
+             { return static_cast<double>(n) * n * n; },
+             "relaxations"});
+    }
+
+    void register_search_benchmarks()
+    {
+        register_a_star();
+        register_floyd_warshall();
+    }
+} // namespace bench
@@ -6,6 +6,7 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <algorithm>
+#include "instrumentation.hpp"
 
 namespace utils
 {
@@ -85,7 +86,10 @@ namespace utils
         open_list.pop();
 
         if (closed_list.count(current))
+        {
+          UTILS_COUNT("a_star.stale");
           continue; // Node already processed with a better or equal cost
+        }
 
 #ifdef UTILS_A_STAR_ENABLE_NAVIGATION
         backtrack_to(find_common_ancestor(c_node, current));
@@ -102,6 +106,7 @@ namespace utils
           return current;
 
         closed_list.insert(current);
+        UTILS_COUNT("a_star.expanded");
 
         for (const auto &[neighbor, cost] : current->get_successors())
         {
@@ -110,8 +115,13 @@ namespace utils
 
           Tp tentative_g_score = g_score.at(current) + cost;
 
-          if (!g_score.count(neighbor) || tentative_g_score < g_score.at(neighbor))
+          const auto g_it = g_score.find(neighbor);
+          if (g_it == g_score.end() || tentative_g_score < g_it->second)
           {
+            if (g_it == g_score.end())
+              UTILS_COUNT("a_star.generated");
+            else
+              UTILS_COUNT("a_star.reopened"); // a cheaper path to a node which is still open..
             came_from[neighbor] = current;
             g_score[neighbor] = tentative_g_score;
             Tp f_cost = tentative_g_score + neighbor->cost(goal);
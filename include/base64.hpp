@@ -1,76 +1,211 @@
 #pragma once
 
 #include <string>
+#include <string_view>
+#include <stdexcept>
+#include <iosfwd>
 
 namespace utils
 {
     static std::string const base64_chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 
-    [[nodiscard]] inline std::string base64_encode(unsigned char const *input, size_t len)
+    /**
+     * @brief The base64 alphabets.
+     */
+    enum class base64_alphabet
+    {
+        standard, // RFC 4648 section 4 ('+' and '/'), padded with '='..
+        url       // RFC 4648 section 5 ('-' and '_'), unpadded..
+    };
+
+    /**
+     * @brief The implementations of the base64 encoding and decoding.
+     */
+    enum class base64_backend
     {
-        std::string ret;
-        int i = 0;
-        int j = 0;
-        unsigned char char_array_3[3];
-        unsigned char char_array_4[4];
-
-        while (len--)
-        {
-            char_array_3[i++] = *(input++);
-            if (i == 3)
-            {
-                char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-                char_array_4[1] = ((char_array_3[0] & 0x03) << 4) +
-                                  ((char_array_3[1] & 0xf0) >> 4);
-                char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) +
-                                  ((char_array_3[2] & 0xc0) >> 6);
-                char_array_4[3] = char_array_3[2] & 0x3f;
-
-                for (i = 0; (i < 4); i++)
-                    ret += base64_chars[char_array_4[i]];
-                i = 0;
-            }
-        }
-
-        if (i)
-        {
-            for (j = i; j < 3; j++)
-                char_array_3[j] = '\0';
-
-            char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-            char_array_4[1] = ((char_array_3[0] & 0x03) << 4) +
-                              ((char_array_3[1] & 0xf0) >> 4);
-            char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) +
-                              ((char_array_3[2] & 0xc0) >> 6);
-            char_array_4[3] = char_array_3[2] & 0x3f;
-
-            for (j = 0; (j < i + 1); j++)
-                ret += base64_chars[char_array_4[j]];
-
-            while ((i++ < 3))
-                ret += '=';
-        }
+        portable, // plain C++..
+        ssse3,    // 12 bytes to 16 characters (and back) at a time..
+        avx2      // 24 bytes to 32 characters (and back) at a time..
+    };
+
+    /**
+     * @brief Returns the backend used for encoding and decoding.
+     *
+     * Unless overridden through `set_base64_backend`, the fastest backend supported by the CPU is selected on the first use.
+     */
+    [[nodiscard]] base64_backend get_base64_backend() noexcept;
+    /**
+     * @brief Sets the backend used for encoding and decoding.
+     *
+     * @param backend The backend.
+     * @return bool True if the backend is supported by the CPU (and has been set), false otherwise.
+     */
+    bool set_base64_backend(base64_backend backend) noexcept;
 
+    /**
+     * @brief Returns the number of characters of the encoding of `len` bytes.
+     */
+    [[nodiscard]] constexpr size_t base64_encoded_size(size_t len, base64_alphabet alphabet = base64_alphabet::standard) noexcept { return alphabet == base64_alphabet::standard ? (len + 2) / 3 * 4 : len / 3 * 4 + (len % 3 ? len % 3 + 1 : 0); }
+    /**
+     * @brief Returns an upper bound on the number of bytes decoded from `len` characters.
+     */
+    [[nodiscard]] constexpr size_t base64_decoded_max_size(size_t len) noexcept { return len / 4 * 3 + (len % 4 > 1 ? len % 4 - 1 : 0); }
+
+    /**
+     * @brief The value returned by `base64_decode` for invalid inputs.
+     */
+    inline constexpr size_t base64_invalid = static_cast<size_t>(-1);
+
+    /**
+     * @brief Encodes `len` bytes into `output`, which must hold at least `base64_encoded_size(len, alphabet)` characters.
+     *
+     * @return size_t The number of characters written.
+     */
+    size_t base64_encode(const unsigned char *input, size_t len, char *output, base64_alphabet alphabet = base64_alphabet::standard) noexcept;
+    /**
+     * @brief Decodes `len` characters into `output`, which must hold at least `base64_decoded_max_size(len)` bytes.
+     *
+     * Trailing padding is accepted, but not required, for both alphabets. The characters are validated in bulk, without branching on each character.
+     *
+     * @return size_t The number of bytes written, or `base64_invalid` if the input contains characters outside the alphabet or has an invalid length.
+     */
+    size_t base64_decode(const char *input, size_t len, unsigned char *output, base64_alphabet alphabet = base64_alphabet::standard) noexcept;
+
+    [[nodiscard]] inline std::string base64_encode(unsigned char const *input, size_t len)
+    {
+        std::string ret(base64_encoded_size(len), '\0');
+        base64_encode(input, len, ret.data());
         return ret;
     }
 
     [[nodiscard]] inline std::string base64url_encode(const unsigned char *input, size_t len)
     {
-        std::string base64 = base64_encode(input, len);
-
-        // Step 1: Replace '+' with '-', '/' with '_'
-        for (auto &c : base64)
-            if (c == '+')
-                c = '-';
-            else if (c == '/')
-                c = '_';
+        std::string ret(base64_encoded_size(len, base64_alphabet::url), '\0');
+        base64_encode(input, len, ret.data(), base64_alphabet::url);
+        return ret;
+    }
 
-        // Step 2: Remove trailing '=' chars (padding)
-        while (!base64.empty() && base64.back() == '=')
-            base64.pop_back();
+    [[nodiscard]] inline std::string base64url_encode(const std::string &input) { return base64url_encode(reinterpret_cast<const unsigned char *>(input.data()), input.size()); }
 
-        return base64;
+    /**
+     * @brief Decodes a base64 string.
+     *
+     * @throws std::invalid_argument if the input is not valid base64.
+     */
+    [[nodiscard]] inline std::string base64_decode(std::string_view input, base64_alphabet alphabet = base64_alphabet::standard)
+    {
+        std::string ret(base64_decoded_max_size(input.size()), '\0');
+        const size_t len = base64_decode(input.data(), input.size(), reinterpret_cast<unsigned char *>(ret.data()), alphabet);
+        if (len == base64_invalid)
+            throw std::invalid_argument("invalid base64 input");
+        ret.resize(len);
+        return ret;
     }
 
-    [[nodiscard]] inline std::string base64url_encode(const std::string &input) { return base64url_encode(reinterpret_cast<const unsigned char *>(input.data()), input.size()); }
+    [[nodiscard]] inline std::string base64url_decode(std::string_view input) { return base64_decode(input, base64_alphabet::url); }
+
+    /**
+     * @brief The outcome of a streaming encoding or decoding step.
+     */
+    struct base64_step
+    {
+        size_t consumed; // the number of input bytes (or characters) consumed..
+        size_t written;  // the number of output characters (or bytes) written..
+    };
+
+    /**
+     * @brief A streaming base64 encoder.
+     *
+     * The input can be fed in chunks of arbitrary size, the 0-2 trailing bytes of each chunk which do not form a whole group being carried over to the following call. The output is written into bounded buffers, so that the memory needed to encode a payload does not depend on its size.
+     */
+    class base64_encoder final
+    {
+    public:
+        static constexpr size_t max_finish_size = 4; // the number of characters written, at most, by `finish`..
+
+        base64_encoder(base64_alphabet alphabet = base64_alphabet::standard) noexcept : alphabet(alphabet) {}
+
+        /**
+         * @brief Encodes a chunk of the input.
+         *
+         * Input is consumed only as long as its encoding fits in the output buffer, so that the caller must feed the unconsumed bytes again. Any buffer of at least four characters guarantees progress.
+         *
+         * @param input The chunk of the input.
+         * @param len The number of bytes of the chunk.
+         * @param output The buffer receiving the characters.
+         * @param capacity The number of characters the buffer can hold.
+         * @return base64_step The number of consumed bytes and of written characters.
+         */
+        base64_step update(const unsigned char *input, size_t len, char *output, size_t capacity) noexcept;
+        /**
+         * @brief Encodes the carried over bytes, with their padding, and resets the encoder.
+         *
+         * @param output The buffer receiving the characters, able to hold at least `max_finish_size` characters.
+         * @return size_t The number of written characters.
+         */
+        size_t finish(char *output) noexcept;
+
+    private:
+        const base64_alphabet alphabet;
+        unsigned char pending[3]; // the carried over bytes..
+        size_t n_pending = 0;
+    };
+
+    /**
+     * @brief A streaming base64 decoder.
+     *
+     * The input can be fed in chunks of arbitrary size. The last (up to four) characters received are held back, since they might be the final, padded, group of the input, and are decoded either when more input arrives or by `finish`. The output is written into bounded buffers, so that the memory needed to decode a payload does not depend on its size.
+     */
+    class base64_decoder final
+    {
+    public:
+        static constexpr size_t max_finish_size = 3; // the number of bytes written, at most, by `finish`..
+
+        base64_decoder(base64_alphabet alphabet = base64_alphabet::standard) noexcept : alphabet(alphabet) {}
+
+        /**
+         * @brief Decodes a chunk of the input.
+         *
+         * Input is consumed only as long as its decoding fits in the output buffer, so that the caller must feed the unconsumed characters again. Any buffer of at least three bytes guarantees progress. Once invalid input is met, the remaining input is discarded until `finish` is called.
+         *
+         * @param input The chunk of the input.
+         * @param len The number of characters of the chunk.
+         * @param output The buffer receiving the bytes.
+         * @param capacity The number of bytes the buffer can hold.
+         * @return base64_step The number of consumed characters and of written bytes.
+         */
+        base64_step update(const char *input, size_t len, unsigned char *output, size_t capacity) noexcept;
+        /**
+         * @brief Decodes the held back characters and resets the decoder.
+         *
+         * @param output The buffer receiving the bytes, able to hold at least `max_finish_size` bytes.
+         * @return size_t The number of written bytes, or `base64_invalid` if the input was not valid base64.
+         */
+        size_t finish(unsigned char *output) noexcept;
+
+        /**
+         * @brief Returns whether invalid input has been met since the last call to `finish`.
+         */
+        [[nodiscard]] bool failed() const noexcept { return invalid; }
+
+    private:
+        void decode_groups(const char *input, size_t n_groups, unsigned char *output) noexcept;
+
+    private:
+        const base64_alphabet alphabet;
+        char pending[4]; // the held back characters..
+        size_t n_pending = 0;
+        bool invalid = false;
+    };
+
+    /**
+     * @brief Encodes the content of `in` into `out` through fixed size buffers.
+     */
+    void base64_encode(std::istream &in, std::ostream &out, base64_alphabet alphabet = base64_alphabet::standard);
+    /**
+     * @brief Decodes the content of `in` into `out` through fixed size buffers.
+     *
+     * @return bool True if the content of `in` is valid base64, false otherwise.
+     */
+    bool base64_decode(std::istream &in, std::ostream &out, base64_alphabet alphabet = base64_alphabet::standard);
 } // namespace utils
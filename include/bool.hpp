@@ -1,11 +1,205 @@
 #pragma once
 
+#include "lit.hpp"
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
 namespace utils
 {
   using lbool = unsigned short int;
   constexpr lbool False = 0;
   constexpr lbool True = 1;
   constexpr lbool Undefined = 2;
+
+  /**
+   * @brief Returns the number of set bits of a 64-bit word.
+   */
+  [[nodiscard]] inline size_t popcount64(uint64_t w) noexcept
+  {
+#ifdef _MSC_VER
+    return static_cast<size_t>(__popcnt64(w));
+#else
+    return static_cast<size_t>(__builtin_popcountll(w));
+#endif
+  }
+
+  /**
+   * @brief Returns the number of trailing zero bits of a non-zero 64-bit word.
+   */
+  [[nodiscard]] inline size_t ctz64(uint64_t w) noexcept
+  {
+#ifdef _MSC_VER
+    unsigned long idx;
+    _BitScanForward64(&idx, w);
+    return static_cast<size_t>(idx);
+#else
+    return static_cast<size_t>(__builtin_ctzll(w));
+#endif
+  }
+
+  /**
+   * @class lbool_vector
+   * @brief A packed vector of `lbool` values, indexed by variable.
+   *
+   * Each value takes two bits, with the same encoding as the `lbool` constants, so that 32 values fit in a 64-bit word. The high bit of each pair is set only for `Undefined` values, so that bulk queries, such as counting or finding the undefined variables, scan whole words through popcount and count-trailing-zeros.
+   * The bits past the last value are kept at zero.
+   */
+  class lbool_vector
+  {
+    static constexpr uint64_t low_bits = 0x5555555555555555ULL; // the low bit of each value..
+
+  public:
+    /**
+     * @brief Constructs a vector of `size` values, all equal to `value`.
+     */
+    explicit lbool_vector(size_t size = 0, lbool value = Undefined) { resize(size, value); }
+
+    /**
+     * @brief Returns the number of values.
+     */
+    [[nodiscard]] size_t size() const noexcept { return n; }
+
+    /**
+     * @brief Resizes the vector, setting the new values to `value`.
+     */
+    void resize(size_t size, lbool value = Undefined)
+    {
+      const size_t old_size = n;
+      words.resize((size + 31) / 32, 0);
+      n = size;
+      if (size > old_size)
+        fill(old_size, size, value);
+      else
+        clear_tail();
+    }
+    /**
+     * @brief Appends a new value, returning its variable.
+     */
+    var push_back(lbool value = Undefined)
+    {
+      if (n % 32 == 0)
+        words.push_back(0);
+      set(n, value);
+      return n++;
+    }
+
+    /**
+     * @brief Returns the value of a variable.
+     */
+    [[nodiscard]] lbool value(var v) const noexcept { return static_cast<lbool>((words[v / 32] >> (v % 32 * 2)) & 3); }
+    /**
+     * @brief Returns the value of a literal, that is the value of its variable, negated if the literal is negative.
+     */
+    [[nodiscard]] lbool value(const lit &p) const noexcept
+    {
+      const lbool val = value(variable(p));
+      return static_cast<lbool>(val ^ ((sign(p) ^ 1) & ~(val >> 1) & 1)); // negative literals flip defined values..
+    }
+    [[nodiscard]] lbool operator[](var v) const noexcept { return value(v); }
+
+    /**
+     * @brief Sets the value of a variable.
+     */
+    void set(var v, lbool value) noexcept
+    {
+      const size_t shift = v % 32 * 2;
+      words[v / 32] = (words[v / 32] & ~(uint64_t(3) << shift)) | (uint64_t(value) << shift);
+    }
+    /**
+     * @brief Makes a literal true, by assigning its variable.
+     */
+    void assign(const lit &p) noexcept { set(variable(p), sign(p) ? True : False); }
+    /**
+     * @brief Makes a variable undefined.
+     */
+    void unassign(var v) noexcept { set(v, Undefined); }
+    /**
+     * @brief Sets all the values to `value`.
+     */
+    void fill(lbool value) noexcept { fill(0, n, value); }
+
+    /**
+     * @brief Returns the number of values equal to `value`.
+     */
+    [[nodiscard]] size_t count(lbool value) const noexcept
+    {
+      size_t c = 0;
+      for (const uint64_t w : words)
+        c += popcount64(matches(w, value));
+      if (value == False) // the bits past the last value read as false..
+        c -= words.size() * 32 - n;
+      return c;
+    }
+    /**
+     * @brief Returns the number of undefined values.
+     */
+    [[nodiscard]] size_t count_undefined() const noexcept { return count(Undefined); }
+
+    /**
+     * @brief Returns the first variable, not lower than `from`, whose value is equal to `value`, or `size()` if there is none.
+     */
+    [[nodiscard]] var find_next(lbool value, var from = 0) const noexcept
+    {
+      if (from >= n)
+        return n;
+      size_t wi = from / 32;
+      uint64_t m = matches(words[wi], value) & (~uint64_t(0) << (from % 32 * 2));
+      while (!m)
+      {
+        if (++wi == words.size())
+          return n;
+        m = matches(words[wi], value);
+      }
+      const var v = wi * 32 + ctz64(m) / 2;
+      return v < n ? v : n;
+    }
+    /**
+     * @brief Returns the first undefined variable, not lower than `from`, or `size()` if there is none.
+     */
+    [[nodiscard]] var find_next_undefined(var from = 0) const noexcept { return find_next(Undefined, from); }
+
+  private:
+    /**
+     * @brief Returns a word having the low bit of each value of `w` set if the value is equal to `value`.
+     */
+    [[nodiscard]] static uint64_t matches(uint64_t w, lbool value) noexcept
+    {
+      switch (value)
+      {
+      case False:
+        return ~w & ~(w >> 1) & low_bits;
+      case True:
+        return w & ~(w >> 1) & low_bits;
+      default:
+        return (w >> 1) & low_bits;
+      }
+    }
+
+    void fill(size_t first, size_t last, lbool value) noexcept
+    {
+      const uint64_t pattern = low_bits * value;
+      for (; first < last && first % 32; ++first)
+        set(first, value);
+      for (; first + 32 <= last; first += 32)
+        words[first / 32] = pattern;
+      for (; first < last; ++first)
+        set(first, value);
+    }
+
+    void clear_tail() noexcept
+    {
+      if (n % 32)
+        words.back() &= ~(~uint64_t(0) << (n % 32 * 2));
+    }
+
+  private:
+    std::vector<uint64_t> words; // the packed values..
+    size_t n = 0;                // the number of values..
+  };
 } // namespace utils
 
 [[nodiscard]] inline bool is_undefined(utils::lbool value) noexcept { return value == utils::Undefined; }
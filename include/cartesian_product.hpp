@@ -3,6 +3,7 @@
 #include <vector>
 #include <algorithm>
 #include <cassert>
+#include "partition.hpp"
 
 namespace utils
 {
@@ -40,4 +41,99 @@ namespace utils
     }
     return s;
   }
+
+  /**
+   * @brief Compute the number of elements of the cartesian product of a set of vectors.
+   *
+   * @tparam T Type of the elements of the vectors.
+   * @param vs Set of vectors.
+   * @return std::size_t The number of elements of the cartesian product.
+   */
+  template <typename T>
+  [[nodiscard]] std::size_t cartesian_product_count(const std::vector<std::vector<T>> &vs) noexcept
+  {
+    std::size_t c = vs.empty() ? 0 : 1;
+    for (const auto &v : vs)
+      c *= v.size();
+    return c;
+  }
+
+  /**
+   * @brief Compute the rank of an element of the cartesian product, in the order in which the elements are generated by `cartesian_product`.
+   *
+   * The rank is the mixed radix number whose digits are the indices of the element, the last vector being the least significant one.
+   *
+   * @tparam T Type of the elements of the vectors.
+   * @param vs Set of vectors.
+   * @param idx The indices, within each of the vectors, of the components of the element.
+   * @return std::size_t The rank of the element, in `[0, cartesian_product_count(vs))`.
+   */
+  template <typename T>
+  [[nodiscard]] std::size_t rank_cartesian_product(const std::vector<std::vector<T>> &vs, const std::vector<std::size_t> &idx) noexcept
+  {
+    assert(vs.size() == idx.size());
+    std::size_t rank = 0;
+    for (std::size_t i = 0; i < vs.size(); ++i)
+    {
+      assert(idx[i] < vs[i].size());
+      rank = rank * vs[i].size() + idx[i];
+    }
+    return rank;
+  }
+
+  /**
+   * @brief Compute the indices of the element of the cartesian product having the given rank, in the order in which the elements are generated by `cartesian_product`.
+   *
+   * @tparam T Type of the elements of the vectors.
+   * @param vs Set of vectors.
+   * @param rank The rank of the element, in `[0, cartesian_product_count(vs))`.
+   * @return std::vector<std::size_t> The indices, within each of the vectors, of the components of the element.
+   */
+  template <typename T>
+  [[nodiscard]] std::vector<std::size_t> unrank_cartesian_product(const std::vector<std::vector<T>> &vs, std::size_t rank) noexcept
+  {
+    assert(rank < cartesian_product_count(vs));
+    std::vector<std::size_t> idx(vs.size());
+    for (std::size_t i = vs.size(); i > 0; --i)
+    {
+      idx[i - 1] = rank % vs[i - 1].size();
+      rank /= vs[i - 1].size();
+    }
+    return idx;
+  }
+
+  /**
+   * @brief Compute the elements of the cartesian product of a set of vectors whose rank is in the `[first, last)` range.
+   *
+   * The elements are generated in the same order as `cartesian_product`, hence the whole product can be split into contiguous ranges (see `partition_range`) which can be computed independently.
+   *
+   * @tparam T Type of the elements of the vectors.
+   * @param vs Set of vectors.
+   * @param first The rank of the first element.
+   * @param last The rank following the one of the last element.
+   * @return std::vector<std::vector<T>> Elements of the cartesian product whose rank is in the `[first, last)` range.
+   */
+  template <typename T>
+  [[nodiscard]] std::vector<std::vector<T>> cartesian_product(const std::vector<std::vector<T>> &vs, const std::size_t &first, const std::size_t &last) noexcept
+  {
+    assert(first <= last && last <= cartesian_product_count(vs));
+    std::vector<std::vector<T>> s;
+    if (first == last)
+      return s;
+    s.reserve(last - first);
+    auto idx = unrank_cartesian_product(vs, first);
+    for (std::size_t r = first; r < last; ++r)
+    {
+      std::vector<T> c_v;
+      c_v.reserve(vs.size());
+      for (std::size_t i = 0; i < vs.size(); ++i)
+        c_v.emplace_back(vs[i][idx[i]]);
+      s.emplace_back(std::move(c_v));
+
+      // increment the mixed radix counter..
+      for (std::size_t i = vs.size(); i > 0 && ++idx[i - 1] == vs[i - 1].size(); --i)
+        idx[i - 1] = 0;
+    }
+    return s;
+  }
 } // namespace utils
\ No newline at end of file
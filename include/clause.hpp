@@ -0,0 +1,201 @@
+#pragma once
+
+#include "watches.hpp"
+#include <cstdint>
+#include <stdexcept>
+#include <new>
+
+namespace utils
+{
+  /**
+   * @brief A reference to a clause, as the offset, in 8-byte units, of the clause within its `clause_arena`.
+   */
+  using clause_ref = uint32_t;
+  constexpr clause_ref clause_ref_undef = std::numeric_limits<clause_ref>::max();
+
+  /**
+   * @class clause
+   * @brief A clause stored within a `clause_arena`, made of an inline header followed by its literals.
+   *
+   * Clauses are created and destroyed by their arena only.
+   */
+  class clause
+  {
+    friend class clause_arena;
+
+  public:
+    clause(const clause &) = delete;
+    clause &operator=(const clause &) = delete;
+
+    [[nodiscard]] size_t size() const noexcept { return sz; }
+    [[nodiscard]] bool learnt() const noexcept { return is_learnt; }
+    [[nodiscard]] bool removed() const noexcept { return is_removed; }
+
+    /**
+     * @brief Returns the literal block distance of the (learnt) clause.
+     */
+    [[nodiscard]] uint32_t lbd() const noexcept { return lbd_; }
+    void set_lbd(uint32_t l) noexcept { lbd_ = l < max_lbd ? l : max_lbd; }
+    /**
+     * @brief Returns the activity of the (learnt) clause.
+     */
+    [[nodiscard]] float activity() const noexcept { return act; }
+    void set_activity(float a) noexcept { act = a; }
+
+    [[nodiscard]] lit &operator[](size_t i) noexcept { return begin()[i]; }
+    [[nodiscard]] const lit &operator[](size_t i) const noexcept { return begin()[i]; }
+    [[nodiscard]] lit *begin() noexcept { return reinterpret_cast<lit *>(this + 1); }
+    [[nodiscard]] lit *end() noexcept { return begin() + sz; }
+    [[nodiscard]] const lit *begin() const noexcept { return reinterpret_cast<const lit *>(this + 1); }
+    [[nodiscard]] const lit *end() const noexcept { return begin() + sz; }
+
+  private:
+    clause(const lit *lits, uint32_t size, bool learnt) noexcept : sz(size), is_learnt(learnt), is_removed(false), is_relocated(false), lbd_(0)
+    {
+      for (uint32_t i = 0; i < size; ++i)
+        ::new (begin() + i) lit(lits[i]);
+    }
+
+    static constexpr uint32_t max_lbd = (1u << 29) - 1;
+
+    uint32_t sz;                // the number of literals..
+    uint32_t is_learnt : 1;     // whether the clause has been learnt..
+    uint32_t is_removed : 1;    // whether the clause has been removed..
+    uint32_t is_relocated : 1;  // whether the clause has been moved to another arena, leaving a forwarding reference..
+    uint32_t lbd_ : 29;         // the literal block distance..
+    float act = 0;              // the activity..
+    clause_ref forward = 0;     // the new reference of a relocated clause..
+  };
+
+  /**
+   * @class clause_arena
+   * @brief A contiguous region storing clauses, with their inline headers, referenced through 32-bit offsets.
+   *
+   * Clauses are laid out one after the other, so that their literals are read from contiguous memory during the propagation.
+   * The 32-bit references halve the reasons and the lists of clauses, whereas a watch, pairing a reference with a 64-bit blocker literal, is still padded to two words.
+   * Removed clauses are only marked and accounted as wasted: their memory is reclaimed by a compacting garbage collection, which moves the live clauses into a fresh region and fixes all their references.
+   */
+  class clause_arena
+  {
+  public:
+    /**
+     * @brief Constructs an empty arena.
+     *
+     * @param capacity The number of 8-byte units to reserve.
+     */
+    explicit clause_arena(size_t capacity = 0) { mem.reserve(capacity); }
+
+    /**
+     * @brief Returns the number of 8-byte units in use, including the wasted ones.
+     */
+    [[nodiscard]] size_t size() const noexcept { return mem.size(); }
+    /**
+     * @brief Returns the number of 8-byte units held by removed clauses.
+     */
+    [[nodiscard]] size_t wasted() const noexcept { return waste; }
+
+    /**
+     * @brief Creates a new clause, returning its reference.
+     *
+     * Creating clauses may move the arena, invalidating the C++ references and pointers to the clauses, but not their `clause_ref`s.
+     *
+     * @param lits The literals of the clause.
+     * @param size The number of literals.
+     * @param learnt Whether the clause has been learnt.
+     * @return clause_ref The reference to the new clause.
+     */
+    [[nodiscard]] clause_ref alloc(const lit *lits, size_t size, bool learnt = false)
+    {
+      const size_t r = mem.size();
+      const size_t n = units(size);
+      if (r + n >= clause_ref_undef)
+        throw std::length_error("clause arena exhausted");
+      mem.resize(r + n);
+      ::new (&mem[r]) clause(lits, static_cast<uint32_t>(size), learnt);
+      return static_cast<clause_ref>(r);
+    }
+    [[nodiscard]] clause_ref alloc(const std::vector<lit> &lits, bool learnt = false) { return alloc(lits.data(), lits.size(), learnt); }
+
+    [[nodiscard]] clause &operator[](clause_ref r) noexcept { return *std::launder(reinterpret_cast<clause *>(&mem[r])); }
+    [[nodiscard]] const clause &operator[](clause_ref r) const noexcept { return *std::launder(reinterpret_cast<const clause *>(&mem[r])); }
+
+    /**
+     * @brief Removes a clause, whose memory is reclaimed by the next garbage collection.
+     */
+    void free(clause_ref r) noexcept
+    {
+      clause &c = (*this)[r];
+      if (!c.is_removed)
+      {
+        c.is_removed = true;
+        waste += units(c.sz);
+      }
+    }
+
+    /**
+     * @brief Moves a live clause into another arena, leaving a forwarding reference behind, and updates the reference.
+     *
+     * Relocating an already relocated clause just follows its forwarding reference, so that any number of references to the same clause can be relocated.
+     *
+     * @param r The reference to update.
+     * @param to The arena receiving the clause.
+     * @return bool False if the clause has been removed (and the reference has to be dropped), true otherwise.
+     */
+    bool relocate(clause_ref &r, clause_arena &to)
+    {
+      clause &c = (*this)[r];
+      if (c.is_removed)
+        return false;
+      if (!c.is_relocated)
+      {
+        const clause_ref nr = to.alloc(c.begin(), c.sz, c.is_learnt);
+        clause &nc = to[nr];
+        nc.lbd_ = c.lbd_;
+        nc.act = c.act;
+        c.is_relocated = true;
+        c.forward = nr;
+      }
+      r = c.forward;
+      return true;
+    }
+
+    /**
+     * @brief Compacts the arena, dropping the removed clauses.
+     *
+     * The clauses are moved following the watch lists first, so that the clauses visited together during the propagation end up next to each other, and then following `refs`. The watches and the references to removed clauses are dropped.
+     * Any other reference to the clauses (e.g., the reasons of the assigned literals) has to be relocated by `extra`, called as `extra(relocate)` where `relocate(clause_ref &)` behaves as `relocate(r, to)`.
+     *
+     * @param watches The watch lists referring to the clauses.
+     * @param refs The references to all the live clauses.
+     * @param extra The callback relocating any other reference.
+     */
+    template <typename F>
+    void garbage_collect(watch_lists<clause_ref> &watches, std::vector<clause_ref> &refs, F &&extra)
+    {
+      clause_arena to(size() - waste);
+      auto reloc = [this, &to](clause_ref &r)
+      { return relocate(r, to); };
+      watches.relocate(reloc);
+      extra(reloc);
+      size_t j = 0;
+      for (auto r : refs)
+        if (reloc(r))
+          refs[j++] = r;
+      refs.resize(j);
+      mem.swap(to.mem);
+      waste = 0;
+    }
+    void garbage_collect(watch_lists<clause_ref> &watches, std::vector<clause_ref> &refs)
+    {
+      garbage_collect(watches, refs, [](auto &&) {});
+    }
+
+  private:
+    static_assert(sizeof(clause) % sizeof(uint64_t) == 0, "the literals must follow the header at a unit boundary");
+    [[nodiscard]] static size_t units(size_t size) noexcept { return (sizeof(clause) + size * sizeof(lit) + sizeof(uint64_t) - 1) / sizeof(uint64_t); }
+
+  private:
+    std::vector<uint64_t> mem; // the clauses, in 8-byte units..
+    size_t waste = 0;          // the number of units held by removed clauses..
+  };
+} // namespace utils
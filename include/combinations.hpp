@@ -3,7 +3,11 @@
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <numeric>
+#include <limits>
+#include <stdexcept>
 #include <cassert>
+#include "partition.hpp"
 
 namespace utils
 {
@@ -36,4 +40,123 @@ namespace utils
     } while (std::prev_permutation(bitmask.begin(), bitmask.end()));
     return combs;
   }
+
+  /**
+   * @brief Compute the number of combinations of `k` elements out of `n`.
+   *
+   * @param n The number of elements.
+   * @param k The number of elements of the combinations.
+   * @return std::size_t The binomial coefficient `n` choose `k`.
+   * @throws std::overflow_error If the binomial coefficient does not fit into a `std::size_t`.
+   */
+  [[nodiscard]] inline std::size_t combinations_count(const std::size_t &n, const std::size_t &k)
+  {
+    if (k > n)
+      return 0;
+    const std::size_t r = k < n - k ? k : n - k;
+    std::size_t c = 1;
+    for (std::size_t i = 1; i <= r; ++i)
+    { // `c * (n - r + i)` is a multiple of `i`, so we divide before multiplying, keeping the intermediate values within the result..
+      const std::size_t g = std::gcd(c, i);
+      const std::size_t f = (n - r + i) / (i / g);
+      if (c / g > std::numeric_limits<std::size_t>::max() / f)
+        throw std::overflow_error("the number of combinations does not fit into a std::size_t");
+      c = c / g * f;
+    }
+    return c;
+  }
+
+  /**
+   * @brief Compute the rank of a combination, in the order in which the combinations are generated by `combinations`.
+   *
+   * Combinations are ranked through the combinatorial number system, according to the lexicographic order of their (increasing) element indices.
+   *
+   * @param c The increasing indices of the elements of the combination.
+   * @param n The number of elements.
+   * @return std::size_t The rank of the combination, in `[0, combinations_count(n, c.size()))`.
+   * @throws std::overflow_error If the number of combinations does not fit into a `std::size_t`.
+   */
+  [[nodiscard]] inline std::size_t rank_combination(const std::vector<std::size_t> &c, const std::size_t &n)
+  {
+    assert(std::is_sorted(c.cbegin(), c.cend()) && std::adjacent_find(c.cbegin(), c.cend()) == c.cend());
+    assert(c.empty() || c.back() < n);
+    std::size_t rank = 0;
+    std::size_t x = 0;
+    for (std::size_t i = 0; i < c.size(); ++i)
+      for (; x <= c[i]; ++x)
+        if (x < c[i]) // all the combinations having `x` at position `i` precede `c`..
+          rank += combinations_count(n - x - 1, c.size() - i - 1);
+    return rank;
+  }
+
+  /**
+   * @brief Compute the combination having the given rank, in the order in which the combinations are generated by `combinations`.
+   *
+   * @param n The number of elements.
+   * @param k The number of elements of the combination.
+   * @param rank The rank of the combination, in `[0, combinations_count(n, k))`.
+   * @return std::vector<std::size_t> The increasing indices of the elements of the combination.
+   * @throws std::overflow_error If the number of combinations does not fit into a `std::size_t`.
+   */
+  [[nodiscard]] inline std::vector<std::size_t> unrank_combination(const std::size_t &n, const std::size_t &k, std::size_t rank)
+  {
+    assert(rank < combinations_count(n, k));
+    std::vector<std::size_t> c;
+    c.reserve(k);
+    std::size_t x = 0;
+    for (std::size_t i = 0; i < k; ++i, ++x)
+    {
+      for (std::size_t cnt = combinations_count(n - x - 1, k - i - 1); cnt <= rank; cnt = combinations_count(n - x - 1, k - i - 1))
+      { // skip all the combinations having `x` at position `i`..
+        rank -= cnt;
+        ++x;
+      }
+      c.emplace_back(x);
+    }
+    return c;
+  }
+
+  /**
+   * @brief Compute the combinations of the elements of a vector whose rank is in the `[first, last)` range.
+   *
+   * The combinations are generated in the same order as `combinations`, hence the whole enumeration can be split into contiguous ranges (see `partition_range`) which can be computed independently.
+   *
+   * @tparam T Type of the elements of the vector.
+   * @param v The vector.
+   * @param n The number of elements of the combinations.
+   * @param first The rank of the first combination.
+   * @param last The rank following the one of the last combination.
+   * @return std::vector<std::vector<T>> Combinations of the elements of the vector whose rank is in the `[first, last)` range.
+   * @throws std::overflow_error If the number of combinations does not fit into a `std::size_t`.
+   */
+  template <typename T>
+  [[nodiscard]] std::vector<std::vector<T>> combinations(const std::vector<T> &v, const size_t &n, const std::size_t &first, const std::size_t &last)
+  {
+    assert(v.size() >= n);
+    assert(first <= last && last <= combinations_count(v.size(), n));
+    std::vector<std::vector<T>> combs;
+    if (first == last)
+      return combs;
+    combs.reserve(last - first);
+    auto c = unrank_combination(v.size(), n, first);
+    for (std::size_t r = first; r < last; ++r)
+    {
+      std::vector<T> c_comb;
+      c_comb.reserve(n);
+      for (const auto &i : c)
+        c_comb.emplace_back(v[i]);
+      combs.emplace_back(std::move(c_comb));
+
+      // move to the next combination, in lexicographic order..
+      std::size_t i = n;
+      while (i > 0 && c[i - 1] == v.size() - n + i - 1)
+        --i;
+      if (i == 0)
+        break;
+      ++c[i - 1];
+      for (std::size_t j = i; j < n; ++j)
+        c[j] = c[j - 1] + 1;
+    }
+    return combs;
+  }
 } // namespace utils
\ No newline at end of file
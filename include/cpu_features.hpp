@@ -0,0 +1,36 @@
+#pragma once
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define UTILS_X86
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define UTILS_TARGET(features) __attribute__((target(features)))
+#else
+#define UTILS_TARGET(features)
+#endif
+
+namespace utils
+{
+  /**
+   * @brief The instruction set extensions supported by the CPU (and enabled by the operating system).
+   */
+  struct cpu_features
+  {
+    bool ssse3 = false;
+    bool sse41 = false;
+    bool avx2 = false;
+    bool avx512f = false;
+    bool avx512bw = false;
+    bool sha = false;
+  };
+
+  /**
+   * @brief Returns the instruction set extensions supported by the CPU.
+   *
+   * The features are detected, through CPUID, on the first call. On non-x86 CPUs no feature is reported.
+   *
+   * @return const cpu_features& The supported instruction set extensions.
+   */
+  [[nodiscard]] const cpu_features &get_cpu_features() noexcept;
+} // namespace utils
@@ -1,6 +1,20 @@
 #pragma once
 
 #include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <future>
+#include <functional>
+#include <condition_variable>
+#include <thread>
+#include <mutex>
+#include <shared_mutex>
+#include <memory>
+#include <map>
+
+struct evp_pkey_st;
+struct evp_md_ctx_st;
 
 namespace utils
 {
@@ -14,9 +28,10 @@ namespace utils
    * @param password The plain-text password to be encoded.
    * @param salt The salt to be used in the encoding process. Salts are used
    *             to add randomness to the encoding, making it more secure.
+   * @param iterations The number of PBKDF2 iterations.
    * @return A string containing the encoded password.
    */
-  [[nodiscard]] std::string encode_password(std::string_view password, std::string_view salt);
+  [[nodiscard]] std::string encode_password(std::string_view password, std::string_view salt, int iterations = 10000);
   /**
    * @brief Encodes a given password into a pair of strings.
    *
@@ -25,16 +40,88 @@ namespace utils
    * to enhance the security of the encoded password.
    *
    * @param password The plain-text password to be encoded.
+   * @param iterations The number of PBKDF2 iterations.
    * @return A pair of strings, where the first string is the salt and the second
    *         string is the encoded password.
    */
-  [[nodiscard]] std::pair<std::string, std::string> encode_password(std::string_view password);
+  [[nodiscard]] std::pair<std::string, std::string> encode_password(std::string_view password, int iterations = 10000);
+
+  /**
+   * @brief Encodes passwords asynchronously on a bounded pool of worker threads.
+   *
+   * Requests are queued and served, in order, by a fixed number of workers, so that the key derivation runs off the calling threads. Callers block only while the queue is full: when `max_pending` requests are already queued, new requests wait for room, bounding the memory held by the queue.
+   */
+  class password_hasher final
+  {
+  public:
+    /**
+     * @brief Constructs a password hasher and starts its workers.
+     *
+     * @param threads The number of worker threads.
+     * @param iterations The number of PBKDF2 iterations, trading the cost of an attack against the throughput.
+     * @param max_pending The maximum number of queued requests.
+     */
+    password_hasher(size_t threads = std::thread::hardware_concurrency(), int iterations = 10000, size_t max_pending = 1024);
+    /**
+     * @brief Completes the queued requests and stops the workers.
+     */
+    ~password_hasher();
+
+    password_hasher(const password_hasher &) = delete;
+    password_hasher &operator=(const password_hasher &) = delete;
+
+    /**
+     * @brief Encodes a password using the provided salt.
+     *
+     * @return A future holding the encoded password.
+     */
+    [[nodiscard]] std::future<std::string> encode(std::string password, std::string salt);
+    /**
+     * @brief Encodes a password using a random salt.
+     *
+     * @return A future holding the salt and the encoded password.
+     */
+    [[nodiscard]] std::future<std::pair<std::string, std::string>> encode(std::string password);
+    /**
+     * @brief Encodes a batch of passwords, each with its salt.
+     *
+     * @return The futures holding the encoded passwords, in the same order.
+     */
+    [[nodiscard]] std::vector<std::future<std::string>> encode(std::vector<std::pair<std::string, std::string>> passwords);
+    /**
+     * @brief Encodes a password using the provided salt, invoking the callback, on a worker thread, with the encoded password (or with an empty string on failure). Exceptions thrown by the callback are ignored.
+     */
+    void encode(std::string password, std::string salt, std::function<void(std::string)> callback);
+
+    /**
+     * @brief Returns the number of PBKDF2 iterations.
+     */
+    [[nodiscard]] int get_iterations() const noexcept { return iterations; }
+
+  private:
+    void submit(std::function<void()> task);
+    void run();
+
+  private:
+    const int iterations;
+    const size_t max_pending;
+    std::deque<std::function<void()>> tasks; // the queued requests..
+    bool running = true;
+    std::mutex mtx;
+    std::condition_variable cv;      // notified when a request is queued or the workers must stop..
+    std::condition_variable room_cv; // notified when a request leaves the queue..
+    std::vector<std::thread> workers;
+  };
 
   /**
    * @brief Signs data using RS256 algorithm with a private key in PEM format.
    *
    * This function takes a string of data and a private key in PEM format,
-   * and returns the RS256 signature of the data.
+   * and returns the RS256 signature of the data. The signer of the last key
+   * used by the calling thread is cached, so that repeated signatures with
+   * the same key do not parse it again. Only a SHA-256 digest of the PEM is
+   * kept to recognize the key; callers signing many times with the same key
+   * should rather own an `rs256_signer`.
    *
    * @param data The data to be signed.
    * @param private_key_pem The private key in PEM format.
@@ -42,6 +129,124 @@ namespace utils
    */
   [[nodiscard]] std::string sign_rs256(std::string_view data, std::string_view private_key_pem);
 
+  /**
+   * @brief Signs data using RS256 algorithm with a private key parsed once.
+   *
+   * The private key is parsed, and a signing context is initialized with it, on construction. Each signature copies the initialized context into a digest context owned by the calling thread, so that neither the key nor the contexts are set up again.
+   * Signers can be shared among threads.
+   */
+  class rs256_signer final
+  {
+  public:
+    /**
+     * @brief Constructs a signer for the given private key.
+     *
+     * @param private_key_pem The private key in PEM format.
+     * @throws std::runtime_error if the private key cannot be parsed.
+     */
+    rs256_signer(std::string_view private_key_pem);
+    ~rs256_signer();
+
+    rs256_signer(const rs256_signer &) = delete;
+    rs256_signer &operator=(const rs256_signer &) = delete;
+
+    /**
+     * @brief Signs the given data.
+     *
+     * @param data The data to be signed.
+     * @return A string containing the binary RS256 signature of the data.
+     * @throws std::runtime_error if the signature fails.
+     */
+    [[nodiscard]] std::string sign(std::string_view data) const;
+    /**
+     * @brief Signs each of the given data.
+     *
+     * @param data The data to be signed.
+     * @return The binary RS256 signatures of the data, in the same order.
+     * @throws std::runtime_error if a signature fails.
+     */
+    [[nodiscard]] std::vector<std::string> sign(const std::vector<std::string_view> &data) const;
+
+  private:
+    void sign(std::string_view data, std::string &signature, evp_md_ctx_st *ctx) const;
+
+  private:
+    evp_pkey_st *pkey;       // the parsed private key..
+    evp_md_ctx_st *init_ctx; // the signing context initialized with the key, copied by each signature..
+    size_t sig_len;          // the length of the signatures..
+  };
+
+  /**
+   * @brief An RS256 signature to be verified.
+   */
+  struct rs256_token
+  {
+    std::string_view key_id;    // the identifier of the public key..
+    std::string_view data;      // the signed data..
+    std::string_view signature; // the binary RS256 signature..
+  };
+
+  /**
+   * @brief Verifies RS256 signatures against a store of parsed public keys.
+   *
+   * Public keys are parsed once, when added to the store, and are looked up by their identifier (e.g., the `kid` of a JWT). Each key keeps a verification context initialized with it, which is copied into a digest context owned by the calling thread for each verification.
+   * Verifiers can be shared among threads, and keys can be added or removed while other threads are verifying.
+   */
+  class rs256_verifier final
+  {
+  public:
+    rs256_verifier() = default;
+
+    rs256_verifier(const rs256_verifier &) = delete;
+    rs256_verifier &operator=(const rs256_verifier &) = delete;
+
+    /**
+     * @brief Adds a public key to the store, replacing any key with the same identifier.
+     *
+     * @param key_id The identifier of the key.
+     * @param public_key_pem The public key in PEM format.
+     * @throws std::runtime_error if the public key cannot be parsed.
+     */
+    void add_key(std::string_view key_id, std::string_view public_key_pem);
+    /**
+     * @brief Removes a public key from the store.
+     *
+     * @param key_id The identifier of the key.
+     * @return bool True if the key was in the store, false otherwise.
+     */
+    bool remove_key(std::string_view key_id);
+    /**
+     * @brief Checks whether a public key is in the store.
+     */
+    [[nodiscard]] bool has_key(std::string_view key_id) const;
+
+    /**
+     * @brief Verifies an RS256 signature.
+     *
+     * @param key_id The identifier of the public key.
+     * @param data The signed data.
+     * @param signature The binary RS256 signature.
+     * @return bool True if the key is in the store and the signature is valid, false otherwise.
+     */
+    [[nodiscard]] bool verify(std::string_view key_id, std::string_view data, std::string_view signature) const;
+    /**
+     * @brief Verifies a batch of RS256 signatures.
+     *
+     * @param tokens The signatures to be verified.
+     * @return The outcome of each verification, in the same order.
+     */
+    [[nodiscard]] std::vector<bool> verify(const std::vector<rs256_token> &tokens) const;
+
+  private:
+    struct key;
+
+    [[nodiscard]] std::shared_ptr<const key> find(std::string_view key_id) const;
+
+  private:
+    std::map<std::string, std::shared_ptr<const key>, std::less<>> keys; // the parsed public keys, by identifier..
+    mutable std::shared_mutex mtx;
+  };
+
   /**
    * @brief Extracts the public key from a private key in PEM format.
    *
@@ -0,0 +1,123 @@
+#pragma once
+
+#ifdef UTILS_ENABLE_INSTRUMENTATION
+#include <cstdint>
+#include <chrono>
+#include <map>
+#include <string>
+#include <array>
+#include <ostream>
+
+namespace utils
+{
+  /**
+   * @brief Registers a counter, returning its identifier.
+   *
+   * Registering the same name more than once returns the same identifier, so that several sites can contribute to the same counter.
+   */
+  [[nodiscard]] std::uint32_t register_counter(const char *name) noexcept;
+  /**
+   * @brief Registers a histogram, returning its identifier.
+   *
+   * Registering the same name more than once returns the same identifier, so that several sites can contribute to the same histogram.
+   */
+  [[nodiscard]] std::uint32_t register_histogram(const char *name) noexcept;
+
+  /**
+   * @brief Adds `n` to a counter of the calling thread.
+   */
+  void count(std::uint32_t counter, std::uint64_t n = 1) noexcept;
+  /**
+   * @brief Records a value into a histogram of the calling thread.
+   */
+  void record(std::uint32_t histogram, std::uint64_t value) noexcept;
+
+  /**
+   * @brief Records, on destruction, its lifetime in nanoseconds into a histogram and, while tracing, as a trace event.
+   */
+  class scoped_timer final
+  {
+  public:
+    scoped_timer(std::uint32_t histogram) noexcept : histogram(histogram), start(std::chrono::steady_clock::now()) {}
+    ~scoped_timer();
+
+    scoped_timer(const scoped_timer &) = delete;
+    scoped_timer &operator=(const scoped_timer &) = delete;
+
+  private:
+    const std::uint32_t histogram;
+    const std::chrono::steady_clock::time_point start;
+  };
+
+  /**
+   * @brief The aggregated values of a histogram.
+   */
+  struct histogram_snapshot
+  {
+    std::uint64_t count = 0;
+    std::uint64_t sum = 0;
+    std::uint64_t min = 0;
+    std::uint64_t max = 0;
+    std::array<std::uint64_t, 65> buckets{}; // the `i`-th bucket counts the values having `i` significant bits, i.e. the values in `[2^(i-1), 2^i)`..
+
+    [[nodiscard]] double mean() const noexcept { return count ? static_cast<double>(sum) / count : 0; }
+  };
+
+  /**
+   * @brief The values of all the counters and histograms, aggregated over all the threads.
+   */
+  struct metrics_snapshot
+  {
+    std::map<std::string, std::uint64_t> counters;
+    std::map<std::string, histogram_snapshot> histograms;
+  };
+
+  /**
+   * @brief Aggregates the counters and the histograms of all the threads.
+   *
+   * The snapshot is consistent for each single value, but not across values recorded concurrently by other threads.
+   */
+  [[nodiscard]] metrics_snapshot get_metrics();
+  /**
+   * @brief Resets all the counters and histograms, and discards the trace events.
+   */
+  void reset_metrics() noexcept;
+  /**
+   * @brief Writes a snapshot of the counters and histograms in JSON.
+   */
+  void write_metrics_json(std::ostream &os);
+
+  /**
+   * @brief Starts recording the scoped timers as trace events.
+   */
+  void start_tracing() noexcept;
+  /**
+   * @brief Stops recording the scoped timers as trace events.
+   */
+  void stop_tracing() noexcept;
+  /**
+   * @brief Writes the recorded trace events in the Chrome trace event format (as loaded by `chrome://tracing` or Perfetto).
+   */
+  void write_chrome_trace(std::ostream &os);
+} // namespace utils
+
+#define UTILS_INSTRUMENTATION_CONCAT_(a, b) a##b
+#define UTILS_INSTRUMENTATION_CONCAT(a, b) UTILS_INSTRUMENTATION_CONCAT_(a, b)
+#if defined(__GNUC__) || defined(__clang__) || (defined(_MSC_VER) && _MSC_VER >= 1925)
+#define UTILS_IS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#else
+#define UTILS_IS_CONSTANT_EVALUATED() false
+#endif
+#define UTILS_METRIC_ID(kind, name) []() noexcept { static const std::uint32_t id = utils::register_##kind(name); return id; }()
+// the counters and the histograms are skipped during constant evaluation, so that they can be used within `constexpr` functions..
+#define UTILS_COUNT(name) (UTILS_IS_CONSTANT_EVALUATED() ? void() : utils::count(UTILS_METRIC_ID(counter, name)))
+#define UTILS_COUNT_N(name, n) (UTILS_IS_CONSTANT_EVALUATED() ? void() : utils::count(UTILS_METRIC_ID(counter, name), n))
+#define UTILS_RECORD(name, value) (UTILS_IS_CONSTANT_EVALUATED() ? void() : utils::record(UTILS_METRIC_ID(histogram, name), value))
+#define UTILS_SCOPED_TIMER(name) utils::scoped_timer UTILS_INSTRUMENTATION_CONCAT(utils_scoped_timer_, __LINE__)(UTILS_METRIC_ID(histogram, name))
+#else
+// without instrumentation, the macros (and their arguments) vanish..
+#define UTILS_COUNT(name) ((void)0)
+#define UTILS_COUNT_N(name, n) ((void)0)
+#define UTILS_RECORD(name, value) ((void)0)
+#define UTILS_SCOPED_TIMER(name) ((void)0)
+#endif
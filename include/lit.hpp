@@ -2,6 +2,7 @@
 
 #include <limits>
 #include <string>
+#include <vector>
 
 namespace utils
 {
@@ -58,6 +59,52 @@ namespace utils
 
   [[nodiscard]] inline std::string to_string(const lit &p) noexcept { return sign(p) ? ("b" + std::to_string(variable(p))) : ("¬b" + std::to_string(variable(p))); }
 
+  /**
+   * @class lit_map
+   * @brief A dense map from the literals of a set of variables to values of type T.
+   *
+   * The values are stored in a vector indexed by `index(lit)`, so that the two literals of each variable are adjacent and lookups cost no hashing.
+   *
+   * @tparam T The type of the values.
+   */
+  template <typename T>
+  class lit_map
+  {
+  public:
+    /**
+     * @brief Constructs a map over the literals of `n_vars` variables, with default constructed values.
+     */
+    explicit lit_map(size_t n_vars = 0) : values(n_vars * 2) {}
+
+    /**
+     * @brief Returns the number of variables whose literals are mapped.
+     */
+    [[nodiscard]] size_t vars() const noexcept { return values.size() / 2; }
+    /**
+     * @brief Extends the map to the literals of `n_vars` variables.
+     */
+    void resize(size_t n_vars) { values.resize(n_vars * 2); }
+    /**
+     * @brief Extends the map to the literals of a new variable, returning the variable.
+     */
+    var add_var()
+    {
+      values.resize(values.size() + 2);
+      return values.size() / 2 - 1;
+    }
+
+    [[nodiscard]] T &operator[](const lit &p) noexcept { return values[index(p)]; }
+    [[nodiscard]] const T &operator[](const lit &p) const noexcept { return values[index(p)]; }
+
+    [[nodiscard]] typename std::vector<T>::iterator begin() noexcept { return values.begin(); }
+    [[nodiscard]] typename std::vector<T>::iterator end() noexcept { return values.end(); }
+    [[nodiscard]] typename std::vector<T>::const_iterator begin() const noexcept { return values.begin(); }
+    [[nodiscard]] typename std::vector<T>::const_iterator end() const noexcept { return values.end(); }
+
+  private:
+    std::vector<T> values; // the values, indexed by `index(lit)`..
+  };
+
   constexpr var FALSE_var = 0;
   constexpr lit FALSE_lit(FALSE_var);
   constexpr lit TRUE_lit = !FALSE_lit;
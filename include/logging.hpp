@@ -28,40 +28,206 @@
 #define COLOR_YELLOW "\033[33m"
 #define COLOR_BLUE "\033[34m"
 #endif
+
+#ifdef LOGGING_ASYNC
+#include <cstddef>
+#ifdef LOGGING_BINARY
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <sstream>
+#include <type_traits>
+#endif
+
+namespace utils
+{
+  /**
+   * @brief The policy applied when the log buffer of a thread is full.
+   */
+  enum class log_overflow_policy
+  {
+    block, // the logging thread waits for the background thread to make room..
+    drop   // the log record is dropped and counted..
+  };
+
+  /**
+   * @brief Sets the policy applied when the log buffer of a thread is full.
+   */
+  void set_log_overflow_policy(log_overflow_policy policy) noexcept;
+  /**
+   * @brief Sets the stream the background thread writes the log records to (`std::cerr` by default).
+   */
+  void set_log_sink(std::ostream &sink) noexcept;
+  /**
+   * @brief Returns the number of log records dropped because of full log buffers.
+   */
+  [[nodiscard]] std::size_t dropped_log_records() noexcept;
+  /**
+   * @brief Waits until all the log records produced so far have been written to the sink.
+   */
+  void flush_log() noexcept;
+
+  /**
+   * @brief A log line being formatted.
+   *
+   * The line is formatted, on the calling thread, into a reusable thread-local buffer, one for each level of nested log lines. On destruction, the line is pushed into the lock-free ring buffer of the calling thread, which is drained in batches by a background thread.
+   */
+  class log_line final
+  {
+  public:
+    log_line(bool sync = false);
+    ~log_line();
+
+    log_line(const log_line &) = delete;
+    log_line &operator=(const log_line &) = delete;
+
+    [[nodiscard]] std::ostream &stream() noexcept { return os; }
+
+  private:
+    std::ostream &os;
+    const bool sync; // whether to wait for the line to be written to the sink..
+  };
+
+#ifdef LOGGING_BINARY
+  /**
+   * @brief The type tags of the arguments of a binary log record.
+   */
+  enum class log_arg : unsigned char
+  {
+    boolean,   // one byte..
+    character, // one byte..
+    int64,     // a signed 64-bit integer..
+    uint64,    // an unsigned 64-bit integer..
+    float64,   // a double..
+    string     // a 32-bit length followed by the characters..
+  };
+
+  /**
+   * @brief Registers a logging site, returning its identifier.
+   *
+   * Each `LOG_*` call site registers itself once, so that its records only carry the identifier of the site.
+   */
+  [[nodiscard]] std::uint32_t register_log_site(const char *file, unsigned line, unsigned level) noexcept;
+  /**
+   * @brief Sets the stream the background thread writes the raw binary log records to.
+   *
+   * Binary streams are not formatted and can be decoded later through `decode_binary_log` (or the `utils_log_decoder` tool). Setting a text sink through `set_log_sink` restores the formatting on the background thread.
+   */
+  void set_binary_log_sink(std::ostream &sink) noexcept;
+  /**
+   * @brief Formats a binary log stream, as written to a binary sink, into the given text stream.
+   *
+   * @return bool True if the whole binary stream was well-formed, false otherwise.
+   */
+  bool decode_binary_log(std::istream &in, std::ostream &out);
+
+  /**
+   * @brief A binary log record being recorded.
+   *
+   * The record contains the identifier of the logging site and the raw bytes of the arguments, each preceded by its `log_arg` type tag. Arguments whose type has no binary encoding are formatted on the calling thread and recorded as strings. The formatting of the record is deferred to the background thread or to an offline decoder.
+   */
+  class binary_line final
+  {
+  public:
+    binary_line(std::uint32_t site, bool sync = false);
+    ~binary_line();
+
+    binary_line(const binary_line &) = delete;
+    binary_line &operator=(const binary_line &) = delete;
+
+    template <typename T>
+    binary_line &operator<<(const T &arg)
+    {
+      if constexpr (std::is_same_v<T, bool>)
+        put(log_arg::boolean, static_cast<unsigned char>(arg));
+      else if constexpr (std::is_same_v<T, char>)
+        put(log_arg::character, arg);
+      else if constexpr (std::is_enum_v<T>)
+        operator<<(static_cast<std::underlying_type_t<T>>(arg));
+      else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+        put(log_arg::int64, static_cast<std::int64_t>(arg));
+      else if constexpr (std::is_integral_v<T>)
+        put(log_arg::uint64, static_cast<std::uint64_t>(arg));
+      else if constexpr (std::is_floating_point_v<T>)
+        put(log_arg::float64, static_cast<double>(arg));
+      else if constexpr (std::is_convertible_v<const T &, std::string_view>)
+        put_string(std::string_view(arg));
+      else
+      { // no binary encoding, so we format the argument here..
+        std::ostringstream os;
+        os << arg;
+        put_string(os.str());
+      }
+      return *this;
+    }
+
+  private:
+    template <typename V>
+    void put(log_arg tag, const V &value)
+    {
+      buf.push_back(static_cast<char>(tag));
+      buf.append(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+    void put_string(std::string_view str)
+    {
+      const auto len = static_cast<std::uint32_t>(str.size());
+      put(log_arg::string, len);
+      buf.append(str.data(), len);
+    }
+
+  private:
+    std::string &buf;
+    const bool sync; // whether to wait for the record to be written to the sink..
+  };
+#endif
+} // namespace utils
+
+#ifdef LOGGING_BINARY
+#define LOG_SITE(level) []() noexcept { static const std::uint32_t site = utils::register_log_site(__FILE__, __LINE__, level); return site; }()
+#define LOG_WRITE(level, color, msg) utils::binary_line(LOG_SITE(level)) << msg
+#define LOG_WRITE_SYNC(level, color, msg) utils::binary_line(LOG_SITE(level), true) << msg
+#else
+#define LOG_WRITE(level, color, msg) utils::log_line().stream() << color << __FILE__ << "(" << __LINE__ << "): " << msg << COLOR_NORMAL << '\n'
+#define LOG_WRITE_SYNC(level, color, msg) utils::log_line(true).stream() << color << __FILE__ << "(" << __LINE__ << "): " << msg << COLOR_NORMAL << '\n'
+#endif
+#else
+#define LOG_WRITE(level, color, msg) std::cerr << color << __FILE__ << "(" << __LINE__ << "): " << msg << COLOR_NORMAL << std::endl
+#define LOG_WRITE_SYNC(level, color, msg) LOG_WRITE(level, color, msg)
+#endif
 #endif
 
 #if LOGGING_LEVEL >= LOG_TRACE_LEVEL
-#define LOG_TRACE(msg) std::cerr << COLOR_BLUE << __FILE__ << "(" << __LINE__ << "): " << msg << COLOR_NORMAL << std::endl
+#define LOG_TRACE(msg) LOG_WRITE(LOG_TRACE_LEVEL, COLOR_BLUE, msg)
 #else
 #define LOG_TRACE(msg) {}
 #endif
 
 #if LOGGING_LEVEL >= LOG_DEBUG_LEVEL
-#define LOG_DEBUG(msg) std::cerr << COLOR_GREEN << __FILE__ << "(" << __LINE__ << "): " << msg << COLOR_NORMAL << std::endl
+#define LOG_DEBUG(msg) LOG_WRITE(LOG_DEBUG_LEVEL, COLOR_GREEN, msg)
 #else
 #define LOG_DEBUG(msg) {}
 #endif
 
 #if LOGGING_LEVEL >= LOG_INFO_LEVEL
-#define LOG_INFO(msg) std::cerr << COLOR_NORMAL << __FILE__ << "(" << __LINE__ << "): " << msg << COLOR_NORMAL << std::endl
+#define LOG_INFO(msg) LOG_WRITE(LOG_INFO_LEVEL, COLOR_NORMAL, msg)
 #else
 #define LOG_INFO(msg) {}
 #endif
 
 #if LOGGING_LEVEL >= LOG_WARN_LEVEL
-#define LOG_WARN(msg) std::cerr << COLOR_YELLOW << __FILE__ << "(" << __LINE__ << "): " << msg << COLOR_NORMAL << std::endl
+#define LOG_WARN(msg) LOG_WRITE(LOG_WARN_LEVEL, COLOR_YELLOW, msg)
 #else
 #define LOG_WARN(msg) {}
 #endif
 
 #if LOGGING_LEVEL >= LOG_ERR_LEVEL
-#define LOG_ERR(msg) std::cerr << COLOR_RED << __FILE__ << "(" << __LINE__ << "): " << msg << COLOR_NORMAL << std::endl
+#define LOG_ERR(msg) LOG_WRITE(LOG_ERR_LEVEL, COLOR_RED, msg)
 #else
 #define LOG_ERR(msg) {}
 #endif
 
 #if LOGGING_LEVEL >= LOG_FATAL_LEVEL
-#define LOG_FATAL(msg) std::cerr << COLOR_BOLD_RED << __FILE__ << "(" << __LINE__ << "): " << msg << COLOR_NORMAL << std::endl
+#define LOG_FATAL(msg) LOG_WRITE_SYNC(LOG_FATAL_LEVEL, COLOR_BOLD_RED, msg)
 #else
 #define LOG_FATAL(msg) {}
 #endif
@@ -2,30 +2,308 @@
 
 #include <utility>
 #include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <new>
+#include <type_traits>
 
 namespace utils
 {
+  /**
+   * @class arena
+   * @brief A bump-pointer arena allocator.
+   *
+   * Memory is carved, in sequence, from large chunks, so that an allocation costs little more than a pointer increment and the global allocator is only involved once per chunk.
+   * Single allocations are never released: the whole memory of the arena is reclaimed at once, by `reset` or by the destruction of the arena, so that arenas suit the many short-lived objects of a single search episode.
+   * Arenas are not thread-safe: each thread should allocate from its own arena, which also avoids any contention on the global allocator.
+   */
+  class arena
+  {
+    struct alignas(std::max_align_t) chunk
+    {
+      chunk *next; // the next chunk of the list..
+    };
+
+  public:
+    /**
+     * @brief Constructs an empty arena.
+     *
+     * @param chunk_size The size, in bytes, of the chunks the memory is carved from.
+     */
+    explicit arena(size_t chunk_size = 64 * 1024) noexcept : chunk_size(chunk_size) {}
+    arena(const arena &) = delete;
+    arena &operator=(const arena &) = delete;
+    ~arena()
+    {
+      free(chunks);
+      free(large);
+    }
+
+    /**
+     * @brief Allocates a block of memory, which stays valid until the arena is reset or destroyed.
+     *
+     * @param size The size of the block in bytes.
+     * @param align The alignment of the block, which must be a power of two.
+     * @return void* Pointer to the block.
+     */
+    [[nodiscard]] void *allocate(size_t size, size_t align = alignof(std::max_align_t))
+    {
+      const std::uintptr_t p = (cur + align - 1) & ~std::uintptr_t(align - 1);
+      if (p + size <= end)
+      {
+        cur = p + size;
+        return reinterpret_cast<void *>(p);
+      }
+      return allocate_slow(size, align);
+    }
+
+    /**
+     * @brief Reclaims all the memory allocated so far, keeping the current chunk for the next allocations.
+     *
+     * The objects allocated within the arena must have been destroyed already.
+     */
+    void reset() noexcept
+    {
+      free(large);
+      large = nullptr;
+      if (chunks)
+      {
+        free(chunks->next);
+        chunks->next = nullptr;
+        cur = reinterpret_cast<std::uintptr_t>(chunks + 1);
+      }
+    }
+
+  private:
+    void *allocate_slow(size_t size, size_t align)
+    {
+      if (size + align > chunk_size / 4)
+      { // large blocks get a dedicated chunk, so that the current chunk is not wasted..
+        auto c = static_cast<chunk *>(::operator new(sizeof(chunk) + size + align));
+        c->next = large;
+        large = c;
+        const std::uintptr_t p = reinterpret_cast<std::uintptr_t>(c + 1);
+        return reinterpret_cast<void *>((p + align - 1) & ~std::uintptr_t(align - 1));
+      }
+      auto c = static_cast<chunk *>(::operator new(sizeof(chunk) + chunk_size));
+      c->next = chunks;
+      chunks = c;
+      cur = reinterpret_cast<std::uintptr_t>(c + 1);
+      end = cur + chunk_size;
+      return allocate(size, align);
+    }
+
+    static void free(chunk *c) noexcept
+    {
+      while (c)
+      {
+        chunk *next = c->next;
+        ::operator delete(c);
+        c = next;
+      }
+    }
+
+  private:
+    const size_t chunk_size;  // the size of the regular chunks..
+    chunk *chunks = nullptr;  // the regular chunks, the current one first..
+    chunk *large = nullptr;   // the dedicated chunks of the large blocks..
+    std::uintptr_t cur = 0;   // the first free byte of the current chunk..
+    std::uintptr_t end = 0;   // the end of the current chunk..
+  };
+
+  /**
+   * @class object_pool
+   * @brief A pool of fixed-size slots for objects of type T.
+   *
+   * Slots are carved from chunks holding many objects each, and released slots are kept in a free list, so that both allocations and deallocations take constant time and seldom involve the global allocator.
+   * The memory of the chunks is returned to the global allocator only when the pool is destroyed.
+   * Pools are not thread-safe: each thread should allocate from, and release to, its own pool, which also avoids any contention on the global allocator.
+   *
+   * @tparam T The type of the pooled objects.
+   */
+  template <typename T>
+  class object_pool
+  {
+    union slot
+    {
+      slot *next; // the next free slot..
+      alignas(T) unsigned char storage[sizeof(T)];
+    };
+    struct alignas(slot) chunk
+    {
+      chunk *next; // the next chunk of the list..
+    };
+    static_assert(sizeof(chunk) % alignof(slot) == 0, "the slots following the header of a chunk must be aligned");
+
+  public:
+    /**
+     * @brief Constructs an empty pool.
+     *
+     * @param chunk_objects The number of slots of each chunk.
+     */
+    explicit object_pool(size_t chunk_objects = 256) noexcept : chunk_objects(chunk_objects), next_slot(chunk_objects) {}
+    object_pool(const object_pool &) = delete;
+    object_pool &operator=(const object_pool &) = delete;
+    /**
+     * @brief Destructor that releases the chunks of the pool. The pooled objects must have been destroyed already.
+     */
+    ~object_pool()
+    {
+      while (chunks)
+      {
+        chunk *next = chunks->next;
+        ::operator delete(chunks, std::align_val_t{alignof(chunk)});
+        chunks = next;
+      }
+    }
+
+    /**
+     * @brief Allocates an uninitialized slot.
+     *
+     * @return void* Pointer to the slot.
+     */
+    [[nodiscard]] void *allocate()
+    {
+      ++live;
+      if (free_list)
+      {
+        slot *s = free_list;
+        free_list = s->next;
+        return s;
+      }
+      if (next_slot == chunk_objects)
+      {
+        chunk *c;
+        try
+        {
+          c = static_cast<chunk *>(::operator new(sizeof(chunk) + chunk_objects * sizeof(slot), std::align_val_t{alignof(chunk)})); // over-aligned objects included..
+        }
+        catch (...)
+        {
+          --live;
+          throw;
+        }
+        c->next = chunks;
+        chunks = c;
+        next_slot = 0;
+      }
+      return reinterpret_cast<slot *>(chunks + 1) + next_slot++;
+    }
+    /**
+     * @brief Releases a slot obtained through `allocate`.
+     *
+     * @param p Pointer to the slot.
+     */
+    void deallocate(void *p) noexcept
+    {
+      auto s = static_cast<slot *>(p);
+      s->next = free_list;
+      free_list = s;
+      --live;
+    }
+
+    /**
+     * @brief Creates an object within a new slot.
+     *
+     * @tparam Args The types of the arguments to pass to the constructor of T.
+     * @param args The arguments to pass to the constructor of T.
+     * @return T* Pointer to the newly created object.
+     */
+    template <typename... Args>
+    [[nodiscard]] T *create(Args &&...args)
+    {
+      void *p = allocate();
+      try
+      {
+        return ::new (p) T(std::forward<Args>(args)...);
+      }
+      catch (...)
+      {
+        deallocate(p);
+        throw;
+      }
+    }
+    /**
+     * @brief Destroys an object created through `create`, releasing its slot.
+     *
+     * @param ptr Pointer to the object.
+     */
+    void destroy(T *ptr) noexcept
+    {
+      ptr->~T();
+      deallocate(ptr);
+    }
+
+    /**
+     * @brief Returns the number of allocated slots.
+     */
+    [[nodiscard]] size_t size() const noexcept { return live; }
+
+  private:
+    const size_t chunk_objects;  // the number of slots of each chunk..
+    chunk *chunks = nullptr;     // the chunks, the current one first..
+    size_t next_slot;            // the next never used slot of the current chunk..
+    slot *free_list = nullptr;   // the released slots..
+    size_t live = 0;             // the number of allocated slots..
+  };
+
+  /**
+   * @brief The default deleter of unique pointers, deleting the object through `delete`.
+   */
+  template <typename T>
+  struct default_delete
+  {
+    constexpr default_delete() noexcept = default;
+    template <typename U>
+    default_delete(const default_delete<U> &) noexcept {}
+
+    void operator()(T *ptr) const noexcept { delete ptr; }
+  };
+
+  /**
+   * @brief The deleter of unique pointers to objects created within an `object_pool`, returning their slots to the pool.
+   */
+  template <typename T>
+  struct pool_delete
+  {
+    object_pool<T> *pool;
+
+    void operator()(T *ptr) const noexcept { pool->destroy(ptr); }
+  };
+
+  /**
+   * @brief The deleter of unique pointers to objects created within an `arena`, which just destroys them, since the arena reclaims their memory.
+   */
+  template <typename T>
+  struct arena_delete
+  {
+    void operator()(T *ptr) const noexcept { ptr->~T(); }
+  };
+
   /**
    * @class u_ptr
    * @brief A simple unique pointer implementation.
    *
    * This class provides a basic implementation of a unique pointer, which ensures
    * that only one instance of the pointer can own a given resource at a time.
+   * The object is released through the deleter, which is stored as an empty base when stateless (and not final), so that the unique pointer stays a single pointer wide, and as a member otherwise.
    *
    * @tparam T The type of the object being managed.
+   * @tparam D The type of the deleter releasing the object.
    */
-  template <typename T>
+  template <typename T, typename D = default_delete<T>>
   class u_ptr
   {
-    template <typename U>
-    friend class u_ptr; // Allows s_ptr<U> to access s_ptr<T>'s private members
+    template <typename U, typename E>
+    friend class u_ptr; // Allows u_ptr<U> to access u_ptr<T>'s private members
   public:
     /**
      * @brief Constructs a unique pointer with the given raw pointer.
      *
      * @param ptr The raw pointer to manage.
+     * @param deleter The deleter releasing the object.
      */
-    u_ptr(T *ptr = nullptr) : ptr(ptr) {}
+    u_ptr(T *ptr = nullptr, D deleter = D()) noexcept : h(ptr, std::move(deleter)) {}
     /**
      * @brief Deleted copy constructor to prevent copying.
      *
@@ -37,46 +315,58 @@ namespace utils
      *
      * @param other The other unique pointer to move from.
      */
-    u_ptr(u_ptr &&other) noexcept : ptr(other.ptr) { other.ptr = nullptr; }
+    u_ptr(u_ptr &&other) noexcept : h(other.h.ptr, std::move(other.get_deleter())) { other.h.ptr = nullptr; }
     /**
      * @brief Move constructor to transfer ownership from another unique pointer.
      *
      * @tparam U The type of the object being managed by the other unique pointer.
+     * @tparam E The type of the deleter of the other unique pointer.
      * @param other The other unique pointer to move from.
      */
-    template <typename U>
-    u_ptr(u_ptr<U> &&other) : ptr(other.ptr) { other.ptr = nullptr; }
+    template <typename U, typename E>
+    u_ptr(u_ptr<U, E> &&other) noexcept : h(other.h.ptr, std::move(other.get_deleter())) { other.h.ptr = nullptr; }
     /**
-     * @brief Destructor that deletes the managed object.
+     * @brief Destructor that releases the managed object.
      */
-    ~u_ptr() { delete ptr; }
+    ~u_ptr()
+    {
+      if (h.ptr)
+        get_deleter()(h.ptr);
+    }
 
     /**
      * @brief Retrieves the raw pointer to the managed object.
      *
      * @return T* Pointer to the managed object.
      */
-    T *get() const { return ptr; }
+    T *get() const { return h.ptr; }
+    /**
+     * @brief Retrieves the deleter releasing the managed object.
+     *
+     * @return D& Reference to the deleter.
+     */
+    D &get_deleter() noexcept { return h.deleter(); }
+    const D &get_deleter() const noexcept { return h.deleter(); }
 
     /**
      * @brief Overloaded arrow operator to access the managed object.
      *
      * @return T* Pointer to the managed object.
      */
-    T *operator->() const { return ptr; }
+    T *operator->() const { return h.ptr; }
     /**
      * @brief Overloaded dereference operator to access the managed object.
      *
      * @return T& Reference to the managed object.
      */
-    T &operator*() const { return *ptr; }
+    T &operator*() const { return *h.ptr; }
 
     /**
      * @brief Conversion operator to check if the unique pointer is valid.
      *
      * @return bool True if the unique pointer is valid, false otherwise.
      */
-    operator bool() const { return ptr != nullptr; }
+    operator bool() const { return h.ptr != nullptr; }
 
     /**
      * @brief Deleted copy assignment operator to prevent copying.
@@ -91,21 +381,31 @@ namespace utils
      * @param other The other unique pointer to move from.
      * @return u_ptr& Reference to this unique pointer.
      */
-    u_ptr &operator=(u_ptr &&other)
+    u_ptr &operator=(u_ptr &&other) noexcept
     {
-      if (ptr != other.ptr)
+      if (h.ptr != other.h.ptr)
       {
-        delete ptr;
-        ptr = other.ptr;
-        other.ptr = nullptr;
+        u_ptr(std::move(other)).swap(*this);
       }
       return *this;
     }
 
+    /**
+     * @brief Releases the ownership of the managed object, without releasing the object.
+     *
+     * @return T* Pointer to the formerly managed object.
+     */
+    [[nodiscard]] T *release() noexcept
+    {
+      T *ptr = h.ptr;
+      h.ptr = nullptr;
+      return ptr;
+    }
+
     /**
      * @brief Swaps the contents of this unique pointer with another.
      *
-     * This function exchanges the managed object pointers between this unique pointer
+     * This function exchanges the managed object pointers, and the deleters, between this unique pointer
      * and the provided unique pointer `other`. Both pointers must be of the same type.
      *
      * @param other The unique pointer to swap with.
@@ -114,13 +414,33 @@ namespace utils
      */
     void swap(u_ptr &other) noexcept
     {
-      T *tmp = ptr;
-      ptr = other.ptr;
-      other.ptr = tmp;
+      std::swap(h.ptr, other.h.ptr);
+      std::swap(get_deleter(), other.get_deleter());
     }
 
   private:
-    T *ptr;
+    template <typename E, bool = std::is_empty_v<E> && !std::is_final_v<E>>
+    struct holder : E // the deleter takes no room when stateless..
+    {
+      holder(T *ptr, E &&deleter) noexcept : E(std::move(deleter)), ptr(ptr) {}
+
+      E &deleter() noexcept { return *this; }
+      const E &deleter() const noexcept { return *this; }
+
+      T *ptr;
+    };
+    template <typename E>
+    struct holder<E, false> // function pointers, stateful and final deleters are stored as members..
+    {
+      holder(T *ptr, E &&deleter) noexcept : d(std::move(deleter)), ptr(ptr) {}
+
+      E &deleter() noexcept { return d; }
+      const E &deleter() const noexcept { return d; }
+
+      E d;
+      T *ptr;
+    };
+    holder<D> h;
   };
 
   /**
@@ -137,20 +457,265 @@ namespace utils
   template <typename Tp, typename... Args>
   u_ptr<Tp> make_u_ptr(Args &&...args) { return u_ptr<Tp>(new Tp(std::forward<Args>(args)...)); }
 
+  /**
+   * @brief Creates a unique pointer to an object of type Tp within an object pool, to which the object is returned on release.
+   *
+   * @tparam Tp The type of the object to create.
+   * @tparam Args The types of the arguments to pass to the constructor of Tp.
+   * @param pool The object pool.
+   * @param args The arguments to pass to the constructor of Tp.
+   * @return u_ptr<Tp, pool_delete<Tp>> A unique pointer to the newly created object of type Tp.
+   */
+  template <typename Tp, typename... Args>
+  u_ptr<Tp, pool_delete<Tp>> make_u_ptr(object_pool<Tp> &pool, Args &&...args) { return u_ptr<Tp, pool_delete<Tp>>(pool.create(std::forward<Args>(args)...), pool_delete<Tp>{&pool}); }
+
+  /**
+   * @brief Creates a unique pointer to an object of type Tp within an arena, which must outlive the unique pointer.
+   *
+   * @tparam Tp The type of the object to create.
+   * @tparam Args The types of the arguments to pass to the constructor of Tp.
+   * @param a The arena.
+   * @param args The arguments to pass to the constructor of Tp.
+   * @return u_ptr<Tp, arena_delete<Tp>> A unique pointer to the newly created object of type Tp.
+   */
+  template <typename Tp, typename... Args>
+  u_ptr<Tp, arena_delete<Tp>> make_u_ptr(arena &a, Args &&...args) { return u_ptr<Tp, arena_delete<Tp>>(::new (a.allocate(sizeof(Tp), alignof(Tp))) Tp(std::forward<Args>(args)...)); }
+
+  /**
+   * @brief The reference counting policy of shared pointers which are never shared among threads.
+   *
+   * The reference count is a plain integer, so that copying and destroying shared pointers costs no synchronization.
+   */
+  struct non_atomic_rc
+  {
+    using counter = size_t;
+
+    static void increment(counter &c) noexcept { ++c; }
+    /**
+     * @brief Decrements the counter, returning true if it reached zero.
+     */
+    [[nodiscard]] static bool decrement(counter &c) noexcept { return --c == 0; }
+    /**
+     * @brief Increments the counter unless it is zero, returning true if it was incremented.
+     */
+    [[nodiscard]] static bool increment_if_nonzero(counter &c) noexcept { return c ? (++c, true) : false; }
+    [[nodiscard]] static size_t load(const counter &c) noexcept { return c; }
+  };
+
+  /**
+   * @brief The reference counting policy of shared pointers which are shared among threads.
+   *
+   * Increments are relaxed, since a new reference can only be created from an existing one. Decrements are acquire-release, so that all the accesses to the managed object happen before its deletion by the thread releasing the last reference.
+   */
+  struct atomic_rc
+  {
+    using counter = std::atomic<size_t>;
+
+    static void increment(counter &c) noexcept { c.fetch_add(1, std::memory_order_relaxed); }
+    /**
+     * @brief Decrements the counter, returning true if it reached zero.
+     */
+    [[nodiscard]] static bool decrement(counter &c) noexcept { return c.fetch_sub(1, std::memory_order_acq_rel) == 1; }
+    /**
+     * @brief Increments the counter unless it is zero, returning true if it was incremented.
+     */
+    [[nodiscard]] static bool increment_if_nonzero(counter &c) noexcept
+    {
+      size_t count = c.load(std::memory_order_relaxed);
+      while (count && !c.compare_exchange_weak(count, count + 1, std::memory_order_acq_rel, std::memory_order_relaxed))
+        ;
+      return count != 0;
+    }
+    [[nodiscard]] static size_t load(const counter &c) noexcept { return c.load(std::memory_order_relaxed); }
+  };
+
+  template <typename T, typename RC = non_atomic_rc>
+  class s_ptr;
+  template <typename T, typename RC = non_atomic_rc>
+  class w_ptr;
+  template <typename Tp, typename RC = non_atomic_rc, typename... Args>
+  s_ptr<Tp, RC> make_s_ptr(Args &&...args);
+  template <typename Tp, typename RC = non_atomic_rc, typename... Args>
+  s_ptr<Tp, RC> make_s_ptr(arena &a, Args &&...args);
+  template <typename T, typename RC>
+  struct s_ptr_pooled;
+  template <typename Tp, typename RC = non_atomic_rc, typename... Args>
+  s_ptr<Tp, RC> make_s_ptr(object_pool<s_ptr_pooled<Tp, RC>> &pool, Args &&...args);
+
+  /**
+   * @brief The control block of an object managed by shared pointers.
+   *
+   * The control block holds the strong and the weak reference counts, and the function which destroys the object, once the strong count drops to zero, and frees the block itself, once the weak count drops to zero as well.
+   */
+  template <typename RC>
+  struct s_ptr_control
+  {
+    enum class op
+    {
+      destroy,   // destroys the managed object..
+      deallocate // frees the control block..
+    };
+    using manage_fn = void (*)(s_ptr_control *, op) noexcept;
+
+    s_ptr_control(manage_fn manage) noexcept : manage(manage) {}
+
+    /**
+     * @brief Releases a strong reference, destroying the object on the last one.
+     */
+    void release() noexcept
+    {
+      if (RC::decrement(ref_count))
+      {
+        manage(this, op::destroy);
+        release_weak();
+      }
+    }
+    /**
+     * @brief Releases a weak reference, freeing the control block on the last one.
+     */
+    void release_weak() noexcept
+    {
+      if (RC::decrement(weak_count))
+        manage(this, op::deallocate);
+    }
+
+    typename RC::counter ref_count{1};  // the number of shared pointers..
+    typename RC::counter weak_count{1}; // the number of weak pointers, plus one while there are shared pointers..
+    const manage_fn manage;
+  };
+
+  /**
+   * @brief The control block of an object allocated separately, as adopted by the raw pointer constructor of `s_ptr`.
+   */
+  template <typename T, typename RC>
+  struct s_ptr_owner final : s_ptr_control<RC>
+  {
+    s_ptr_owner(T *ptr) noexcept : s_ptr_control<RC>(&manage), ptr(ptr) {}
+
+    static void manage(s_ptr_control<RC> *ctrl, typename s_ptr_control<RC>::op o) noexcept
+    {
+      auto owner = static_cast<s_ptr_owner *>(ctrl);
+      if (o == s_ptr_control<RC>::op::destroy)
+        delete owner->ptr;
+      else
+        delete owner;
+    }
+
+    T *const ptr;
+  };
+
+  /**
+   * @brief The control block of an object allocated together with it, as created by `make_s_ptr`.
+   *
+   * The storage of the object is released together with the control block, once no weak pointer refers to it.
+   */
+  template <typename T, typename RC>
+  struct s_ptr_inplace final : s_ptr_control<RC>
+  {
+    s_ptr_inplace() noexcept : s_ptr_control<RC>(&manage) {}
+
+    [[nodiscard]] T *get() noexcept { return std::launder(reinterpret_cast<T *>(&storage)); }
+
+    static void manage(s_ptr_control<RC> *ctrl, typename s_ptr_control<RC>::op o) noexcept
+    {
+      auto block = static_cast<s_ptr_inplace *>(ctrl);
+      if (o == s_ptr_control<RC>::op::destroy)
+        block->get()->~T();
+      else
+        delete block;
+    }
+
+    alignas(T) unsigned char storage[sizeof(T)];
+  };
+
+  /**
+   * @brief The control block of an object allocated together with it within an arena, as created by `make_s_ptr`.
+   *
+   * The arena reclaims the memory of the block, so the block is just destroyed.
+   */
+  template <typename T, typename RC>
+  struct s_ptr_arena final : s_ptr_control<RC>
+  {
+    s_ptr_arena() noexcept : s_ptr_control<RC>(&manage) {}
+
+    [[nodiscard]] T *get() noexcept { return std::launder(reinterpret_cast<T *>(&storage)); }
+
+    static void manage(s_ptr_control<RC> *ctrl, typename s_ptr_control<RC>::op o) noexcept
+    {
+      auto block = static_cast<s_ptr_arena *>(ctrl);
+      if (o == s_ptr_control<RC>::op::destroy)
+        block->get()->~T();
+      else
+        block->~s_ptr_arena();
+    }
+
+    alignas(T) unsigned char storage[sizeof(T)];
+  };
+
+  /**
+   * @brief The control block of an object allocated together with it within an object pool, as created by `make_s_ptr`.
+   *
+   * The block returns to its pool once no weak pointer refers to it.
+   */
+  template <typename T, typename RC>
+  struct s_ptr_pooled final : s_ptr_control<RC>
+  {
+    s_ptr_pooled(object_pool<s_ptr_pooled> &pool) noexcept : s_ptr_control<RC>(&manage), pool(pool) {}
+
+    [[nodiscard]] T *get() noexcept { return std::launder(reinterpret_cast<T *>(&storage)); }
+
+    static void manage(s_ptr_control<RC> *ctrl, typename s_ptr_control<RC>::op o) noexcept
+    {
+      auto block = static_cast<s_ptr_pooled *>(ctrl);
+      if (o == s_ptr_control<RC>::op::destroy)
+        block->get()->~T();
+      else
+      {
+        auto &pool = block->pool;
+        block->~s_ptr_pooled();
+        pool.deallocate(block);
+      }
+    }
+
+    object_pool<s_ptr_pooled> &pool; // the pool of the block..
+    alignas(T) unsigned char storage[sizeof(T)];
+  };
+
+  /**
+   * @brief A pool of shared objects of type T, together with their control blocks.
+   */
+  template <typename T, typename RC = non_atomic_rc>
+  using s_ptr_pool = object_pool<s_ptr_pooled<T, RC>>;
+
   /**
    * @class s_ptr
    * @brief A simple shared pointer implementation.
    *
    * This class provides a basic implementation of a shared pointer, which allows
    * multiple instances of the pointer to own a given resource at the same time.
+   * The reference counting policy is chosen at compile time: `non_atomic_rc` (the default) for single-threaded code,
+   * `atomic_rc` for objects shared among threads. As for `std::shared_ptr`, distinct shared pointers to the same object
+   * can be used concurrently, while a single shared pointer instance cannot be modified by a thread while accessed by another.
+   *
+   * The reference counts live in a control block. `make_s_ptr` allocates the object within its control block, with a single
+   * allocation, while the raw pointer constructor adopts an object allocated elsewhere, allocating just the control block.
    *
    * @tparam T The type of the object being managed.
+   * @tparam RC The reference counting policy.
    */
-  template <typename T>
+  template <typename T, typename RC>
   class s_ptr
   {
-    template <typename U>
+    template <typename U, typename P>
     friend class s_ptr; // Allows s_ptr<U> to access s_ptr<T>'s private members
+    template <typename U, typename P>
+    friend class w_ptr;
+    template <typename Tp, typename P, typename... Args>
+    friend s_ptr<Tp, P> make_s_ptr(Args &&...args);
+    template <typename Tp, typename P, typename... Args>
+    friend s_ptr<Tp, P> make_s_ptr(arena &a, Args &&...args);
+    template <typename Tp, typename P, typename... Args>
+    friend s_ptr<Tp, P> make_s_ptr(object_pool<s_ptr_pooled<Tp, P>> &pool, Args &&...args);
 
   public:
     /**
@@ -158,16 +723,16 @@ namespace utils
      *
      * @param ptr The raw pointer to manage.
      */
-    s_ptr(T *ptr = nullptr) : ptr(ptr), ref_count(ptr ? new size_t(1) : nullptr) {}
+    s_ptr(T *ptr = nullptr) : ptr(ptr), ctrl(ptr ? adopt(ptr) : nullptr) {}
     /**
      * @brief Copy constructor to share ownership with another shared pointer.
      *
      * @param other The other shared pointer to copy from.
      */
-    s_ptr(const s_ptr &other) : ptr(other.ptr), ref_count(other.ref_count)
+    s_ptr(const s_ptr &other) : ptr(other.ptr), ctrl(other.ctrl)
     {
-      if (ref_count)
-        ++(*ref_count);
+      if (ctrl)
+        RC::increment(ctrl->ref_count);
     }
     /**
      * @brief Copy constructor to share ownership with another shared pointer.
@@ -176,20 +741,20 @@ namespace utils
      * @param other The other shared pointer to copy from.
      */
     template <typename U>
-    s_ptr(const s_ptr<U> &other) : ptr(static_cast<T *>(other.ptr)), ref_count(other.ref_count)
+    s_ptr(const s_ptr<U, RC> &other) : ptr(static_cast<T *>(other.ptr)), ctrl(other.ctrl)
     {
-      if (ref_count)
-        ++(*ref_count);
+      if (ctrl)
+        RC::increment(ctrl->ref_count);
     }
     /**
      * @brief Move constructor to transfer ownership from another shared pointer.
      *
      * @param other The other shared pointer to move from.
      */
-    s_ptr(s_ptr &&other) noexcept : ptr(other.ptr), ref_count(other.ref_count)
+    s_ptr(s_ptr &&other) noexcept : ptr(other.ptr), ctrl(other.ctrl)
     {
       other.ptr = nullptr;
-      other.ref_count = nullptr;
+      other.ctrl = nullptr;
     }
     /**
      * @brief Move constructor to transfer ownership from another shared pointer.
@@ -198,10 +763,10 @@ namespace utils
      * @param other The other shared pointer to move from.
      */
     template <typename U>
-    s_ptr(s_ptr<U> &&other) : ptr(other.ptr), ref_count(other.ref_count)
+    s_ptr(s_ptr<U, RC> &&other) : ptr(other.ptr), ctrl(other.ctrl)
     {
       other.ptr = nullptr;
-      other.ref_count = nullptr;
+      other.ctrl = nullptr;
     }
     /**
      * @brief Destructor that deletes the managed object if no other shared pointers own it.
@@ -220,9 +785,9 @@ namespace utils
       {
         release();
         ptr = other.ptr;
-        ref_count = other.ref_count;
-        if (ref_count)
-          ++(*ref_count);
+        ctrl = other.ctrl;
+        if (ctrl)
+          RC::increment(ctrl->ref_count);
       }
       return *this;
     }
@@ -234,15 +799,15 @@ namespace utils
      * @return s_ptr& Reference to this shared pointer.
      */
     template <typename U>
-    s_ptr &operator=(const s_ptr<U> &other)
+    s_ptr &operator=(const s_ptr<U, RC> &other)
     {
       if (ptr != other.ptr)
       {
         release();
         ptr = static_cast<T *>(other.ptr);
-        ref_count = other.ref_count;
-        if (ref_count)
-          ++(*ref_count);
+        ctrl = other.ctrl;
+        if (ctrl)
+          RC::increment(ctrl->ref_count);
       }
       return *this;
     }
@@ -259,9 +824,9 @@ namespace utils
       {
         release();
         ptr = other.ptr;
-        ref_count = other.ref_count;
+        ctrl = other.ctrl;
         other.ptr = nullptr;
-        other.ref_count = nullptr;
+        other.ctrl = nullptr;
       }
       return *this;
     }
@@ -273,15 +838,15 @@ namespace utils
      * @return s_ptr& Reference to this shared pointer.
      */
     template <typename U>
-    s_ptr &operator=(s_ptr<U> &&other)
+    s_ptr &operator=(s_ptr<U, RC> &&other)
     {
       if (ptr != other.ptr)
       {
         release();
         ptr = other.ptr;
-        ref_count = other.ref_count;
+        ctrl = other.ctrl;
         other.ptr = nullptr;
-        other.ref_count = nullptr;
+        other.ctrl = nullptr;
       }
       return *this;
     }
@@ -316,34 +881,289 @@ namespace utils
     /**
      * @brief Returns the number of shared pointers owning the managed object.
      *
+     * With the `atomic_rc` policy, the returned value is only a snapshot, which other threads may change at any time.
+     *
      * @return size_t The number of shared pointers owning the managed object.
      */
-    size_t use_count() { return ref_count ? *ref_count : 0; }
+    size_t use_count() const { return ctrl ? RC::load(ctrl->ref_count) : 0; }
 
   private:
-    inline void release()
+    s_ptr(T *ptr, s_ptr_control<RC> *ctrl) noexcept : ptr(ptr), ctrl(ctrl) {}
+
+    static s_ptr_control<RC> *adopt(T *ptr)
     {
-      if (ref_count && --(*ref_count) == 0)
+      try
       {
+        return new s_ptr_owner<T, RC>(ptr);
+      }
+      catch (...)
+      { // we do not leak the adopted object..
         delete ptr;
-        delete ref_count;
+        throw;
       }
     }
 
+    inline void release()
+    {
+      if (ctrl)
+        ctrl->release();
+    }
+
   private:
     T *ptr;
-    size_t *ref_count;
+    s_ptr_control<RC> *ctrl; // the control block, holding the reference count..
   };
 
+  /**
+   * @brief A shared pointer which can be shared among threads.
+   */
+  template <typename T>
+  using atomic_s_ptr = s_ptr<T, atomic_rc>;
+
+  /**
+   * @class w_ptr
+   * @brief A weak pointer to an object managed by shared pointers.
+   *
+   * Weak pointers do not keep the managed object alive, so that they can break the reference cycles of shared pointers.
+   * The object is accessed by locking the weak pointer into a shared pointer, which is empty if the object has already been destroyed.
+   * The control block of the object survives until the last weak pointer to it is gone.
+   *
+   * @tparam T The type of the object being referred to.
+   * @tparam RC The reference counting policy of the shared pointers.
+   */
+  template <typename T, typename RC>
+  class w_ptr
+  {
+    template <typename U, typename P>
+    friend class w_ptr; // Allows w_ptr<U> to access w_ptr<T>'s private members
+
+  public:
+    /**
+     * @brief Constructs an empty weak pointer.
+     */
+    w_ptr() noexcept : ptr(nullptr), ctrl(nullptr) {}
+    /**
+     * @brief Constructs a weak pointer to the object managed by a shared pointer.
+     *
+     * @tparam U The type of the object being managed by the shared pointer.
+     * @param other The shared pointer.
+     */
+    template <typename U>
+    w_ptr(const s_ptr<U, RC> &other) noexcept : ptr(other.ptr), ctrl(other.ctrl) { acquire(); }
+    /**
+     * @brief Copy constructor to refer to the same object as another weak pointer.
+     *
+     * @param other The other weak pointer to copy from.
+     */
+    w_ptr(const w_ptr &other) noexcept : ptr(other.ptr), ctrl(other.ctrl) { acquire(); }
+    /**
+     * @brief Copy constructor to refer to the same object as another weak pointer.
+     *
+     * @tparam U The type of the object being referred to by the other weak pointer.
+     * @param other The other weak pointer to copy from.
+     */
+    template <typename U>
+    w_ptr(const w_ptr<U, RC> &other) noexcept : ptr(other.ptr), ctrl(other.ctrl) { acquire(); }
+    /**
+     * @brief Move constructor to take over the reference of another weak pointer.
+     *
+     * @param other The other weak pointer to move from.
+     */
+    w_ptr(w_ptr &&other) noexcept : ptr(other.ptr), ctrl(other.ctrl)
+    {
+      other.ptr = nullptr;
+      other.ctrl = nullptr;
+    }
+    /**
+     * @brief Destructor that releases the control block if no other pointers refer to it.
+     */
+    ~w_ptr() { release(); }
+
+    /**
+     * @brief Copy assignment operator to refer to the same object as another weak pointer.
+     *
+     * @param other The other weak pointer to copy from.
+     * @return w_ptr& Reference to this weak pointer.
+     */
+    w_ptr &operator=(const w_ptr &other) noexcept
+    {
+      w_ptr(other).swap(*this);
+      return *this;
+    }
+    /**
+     * @brief Move assignment operator to take over the reference of another weak pointer.
+     *
+     * @param other The other weak pointer to move from.
+     * @return w_ptr& Reference to this weak pointer.
+     */
+    w_ptr &operator=(w_ptr &&other) noexcept
+    {
+      w_ptr(std::move(other)).swap(*this);
+      return *this;
+    }
+    /**
+     * @brief Assignment operator to refer to the object managed by a shared pointer.
+     *
+     * @tparam U The type of the object being managed by the shared pointer.
+     * @param other The shared pointer.
+     * @return w_ptr& Reference to this weak pointer.
+     */
+    template <typename U>
+    w_ptr &operator=(const s_ptr<U, RC> &other) noexcept
+    {
+      w_ptr(other).swap(*this);
+      return *this;
+    }
+
+    /**
+     * @brief Returns a shared pointer to the object, or an empty shared pointer if the object has been destroyed.
+     *
+     * @return s_ptr<T, RC> A shared pointer to the object.
+     */
+    [[nodiscard]] s_ptr<T, RC> lock() const noexcept
+    {
+      if (ctrl && RC::increment_if_nonzero(ctrl->ref_count))
+        return s_ptr<T, RC>(ptr, ctrl);
+      return s_ptr<T, RC>();
+    }
+    /**
+     * @brief Checks whether the object has been destroyed (or the weak pointer is empty).
+     *
+     * @return bool True if the object has been destroyed, false otherwise.
+     */
+    [[nodiscard]] bool expired() const noexcept { return use_count() == 0; }
+    /**
+     * @brief Returns the number of shared pointers owning the object.
+     *
+     * @return size_t The number of shared pointers owning the object.
+     */
+    [[nodiscard]] size_t use_count() const noexcept { return ctrl ? RC::load(ctrl->ref_count) : 0; }
+
+    /**
+     * @brief Makes the weak pointer empty.
+     */
+    void reset() noexcept { w_ptr().swap(*this); }
+    /**
+     * @brief Swaps the contents of this weak pointer with another.
+     *
+     * @param other The weak pointer to swap with.
+     */
+    void swap(w_ptr &other) noexcept
+    {
+      std::swap(ptr, other.ptr);
+      std::swap(ctrl, other.ctrl);
+    }
+
+  private:
+    inline void acquire() noexcept
+    {
+      if (ctrl)
+        RC::increment(ctrl->weak_count);
+    }
+    inline void release() noexcept
+    {
+      if (ctrl)
+        ctrl->release_weak();
+    }
+
+  private:
+    T *ptr;
+    s_ptr_control<RC> *ctrl; // the control block, holding the reference counts..
+  };
+
+  /**
+   * @brief A weak pointer to an object managed by shared pointers which can be shared among threads.
+   */
+  template <typename T>
+  using atomic_w_ptr = w_ptr<T, atomic_rc>;
+
+  /**
+   * @brief Creates a shared pointer to an object of type Tp.
+   *
+   * The object and its control block are allocated together, with a single allocation, so that the reference count shares the cache lines of the object.
+   *
+   * @tparam Tp The type of the object to create.
+   * @tparam RC The reference counting policy.
+   * @tparam Args The types of the arguments to pass to the constructor of Tp.
+   * @param args The arguments to pass to the constructor of Tp.
+   * @return s_ptr<Tp, RC> A shared pointer to the newly created object of type Tp.
+   */
+  template <typename Tp, typename RC, typename... Args>
+  s_ptr<Tp, RC> make_s_ptr(Args &&...args)
+  {
+    auto block = new s_ptr_inplace<Tp, RC>();
+    try
+    {
+      ::new (static_cast<void *>(&block->storage)) Tp(std::forward<Args>(args)...);
+    }
+    catch (...)
+    {
+      delete block;
+      throw;
+    }
+    return s_ptr<Tp, RC>(block->get(), block);
+  }
+
+  /**
+   * @brief Creates a shared pointer to an object of type Tp, allocated together with its control block within an arena.
+   *
+   * The arena must outlive all the shared and weak pointers to the object.
+   *
+   * @tparam Tp The type of the object to create.
+   * @tparam RC The reference counting policy.
+   * @tparam Args The types of the arguments to pass to the constructor of Tp.
+   * @param a The arena.
+   * @param args The arguments to pass to the constructor of Tp.
+   * @return s_ptr<Tp, RC> A shared pointer to the newly created object of type Tp.
+   */
+  template <typename Tp, typename RC, typename... Args>
+  s_ptr<Tp, RC> make_s_ptr(arena &a, Args &&...args)
+  {
+    auto block = ::new (a.allocate(sizeof(s_ptr_arena<Tp, RC>), alignof(s_ptr_arena<Tp, RC>))) s_ptr_arena<Tp, RC>();
+    ::new (static_cast<void *>(&block->storage)) Tp(std::forward<Args>(args)...); // on failure, the arena reclaims the block..
+    return s_ptr<Tp, RC>(block->get(), block);
+  }
+
+  /**
+   * @brief Creates a shared pointer to an object of type Tp, allocated together with its control block within an object pool.
+   *
+   * The pool must outlive all the shared and weak pointers to the object, which must be released on the thread owning the pool.
+   *
+   * @tparam Tp The type of the object to create.
+   * @tparam RC The reference counting policy.
+   * @tparam Args The types of the arguments to pass to the constructor of Tp.
+   * @param pool The object pool.
+   * @param args The arguments to pass to the constructor of Tp.
+   * @return s_ptr<Tp, RC> A shared pointer to the newly created object of type Tp.
+   */
+  template <typename Tp, typename RC, typename... Args>
+  s_ptr<Tp, RC> make_s_ptr(object_pool<s_ptr_pooled<Tp, RC>> &pool, Args &&...args)
+  {
+    auto block = ::new (pool.allocate()) s_ptr_pooled<Tp, RC>(pool);
+    try
+    {
+      ::new (static_cast<void *>(&block->storage)) Tp(std::forward<Args>(args)...);
+    }
+    catch (...)
+    {
+      pool.deallocate(block);
+      throw;
+    }
+    return s_ptr<Tp, RC>(block->get(), block);
+  }
+
+  /**
+   * @brief Creates a shared pointer, which can be shared among threads, to an object of type Tp.
+   */
   template <typename Tp, typename... Args>
-  s_ptr<Tp> make_s_ptr(Args &&...args) { return s_ptr<Tp>(new Tp(std::forward<Args>(args)...)); }
+  atomic_s_ptr<Tp> make_atomic_s_ptr(Args &&...args) { return make_s_ptr<Tp, atomic_rc>(std::forward<Args>(args)...); }
 
-  template <class To, class From>
-  s_ptr<To> s_ptr_cast(const s_ptr<From> &sp)
+  template <class To, class From, class RC>
+  s_ptr<To, RC> s_ptr_cast(const s_ptr<From, RC> &sp)
   {
     if (auto p = dynamic_cast<To *>(sp.get()))
-      return s_ptr<To>(sp);
-    return s_ptr<To>();
+      return s_ptr<To, RC>(sp);
+    return s_ptr<To, RC>();
   }
 
   /**
@@ -358,8 +1178,8 @@ namespace utils
    * @param b The second smart pointer to compare.
    * @return true if both smart pointers point to the same object, false otherwise.
    */
-  template <class T, class U>
-  inline bool operator==(s_ptr<T> const &a, s_ptr<U> const &b) { return a.get() == b.get(); }
+  template <class T, class U, class RC>
+  inline bool operator==(s_ptr<T, RC> const &a, s_ptr<U, RC> const &b) { return a.get() == b.get(); }
 
   /**
    * @brief Inequality comparison operator for smart pointers.
@@ -373,8 +1193,202 @@ namespace utils
    * @param b The second smart pointer to compare.
    * @return true if both smart pointers point to different objects, false otherwise.
    */
+  template <class T, class U, class RC>
+  inline bool operator!=(s_ptr<T, RC> const &a, s_ptr<U, RC> const &b) { return a.get() != b.get(); }
+
+  /**
+   * @class ref_counted
+   * @brief A mixin embedding the reference count of intrusive pointers within the object.
+   *
+   * Classes derive from `ref_counted<Derived>` to be managed by `i_ptr`. Since the count lives within the object, the intrusive pointers are a single pointer wide and their reference count updates touch the cache lines of the object itself.
+   * The object is deleted as a `Derived`, so classes further deriving from `Derived` need a virtual destructor in `Derived`.
+   * Copying an object does not copy its reference count, since the copy is a distinct object.
+   *
+   * @tparam Derived The class deriving from the mixin.
+   * @tparam RC The reference counting policy.
+   */
+  template <typename Derived, typename RC = non_atomic_rc>
+  class ref_counted
+  {
+    template <typename U>
+    friend class i_ptr;
+
+  public:
+    /**
+     * @brief Returns the number of intrusive pointers owning the object.
+     *
+     * @return size_t The number of intrusive pointers owning the object.
+     */
+    [[nodiscard]] size_t use_count() const noexcept { return RC::load(ref_count); }
+
+  protected:
+    ref_counted() noexcept = default;
+    ref_counted(const ref_counted &) noexcept {}
+    ref_counted &operator=(const ref_counted &) noexcept { return *this; }
+    ~ref_counted() = default;
+
+  private:
+    void add_ref() const noexcept { RC::increment(ref_count); }
+    void release_ref() const noexcept
+    {
+      if (RC::decrement(ref_count))
+        delete static_cast<const Derived *>(this);
+    }
+
+  private:
+    mutable typename RC::counter ref_count{0}; // the number of intrusive pointers owning the object..
+  };
+
+  /**
+   * @class i_ptr
+   * @brief An intrusive shared pointer, for objects deriving from `ref_counted`.
+   *
+   * Unlike `s_ptr`, the intrusive pointer has no control block: it is as wide as a raw pointer, and it can be rebuilt from a raw pointer to an already owned object without creating a second, independent, reference count.
+   * The reference counting policy is the one chosen by the object through `ref_counted`.
+   *
+   * @tparam T The type of the object being managed.
+   */
+  template <typename T>
+  class i_ptr
+  {
+    template <typename U>
+    friend class i_ptr; // Allows i_ptr<U> to access i_ptr<T>'s private members
+
+  public:
+    /**
+     * @brief Constructs an intrusive pointer with the given raw pointer, sharing the ownership of the object with any other intrusive pointer to it.
+     *
+     * @param ptr The raw pointer to manage.
+     */
+    i_ptr(T *ptr = nullptr) noexcept : ptr(ptr)
+    {
+      if (ptr)
+        ptr->add_ref();
+    }
+    /**
+     * @brief Copy constructor to share ownership with another intrusive pointer.
+     *
+     * @param other The other intrusive pointer to copy from.
+     */
+    i_ptr(const i_ptr &other) noexcept : i_ptr(other.ptr) {}
+    /**
+     * @brief Copy constructor to share ownership with another intrusive pointer.
+     *
+     * @tparam U The type of the object being managed by the other intrusive pointer.
+     * @param other The other intrusive pointer to copy from.
+     */
+    template <typename U>
+    i_ptr(const i_ptr<U> &other) noexcept : i_ptr(static_cast<T *>(other.ptr)) {}
+    /**
+     * @brief Move constructor to transfer ownership from another intrusive pointer.
+     *
+     * @param other The other intrusive pointer to move from.
+     */
+    i_ptr(i_ptr &&other) noexcept : ptr(other.ptr) { other.ptr = nullptr; }
+    /**
+     * @brief Move constructor to transfer ownership from another intrusive pointer.
+     *
+     * @tparam U The type of the object being managed by the other intrusive pointer.
+     * @param other The other intrusive pointer to move from.
+     */
+    template <typename U>
+    i_ptr(i_ptr<U> &&other) noexcept : ptr(static_cast<T *>(other.ptr)) { other.ptr = nullptr; }
+    /**
+     * @brief Destructor that deletes the managed object if no other intrusive pointers own it.
+     */
+    ~i_ptr()
+    {
+      if (ptr)
+        ptr->release_ref();
+    }
+
+    /**
+     * @brief Copy assignment operator to share ownership with another intrusive pointer.
+     *
+     * @param other The other intrusive pointer to copy from.
+     * @return i_ptr& Reference to this intrusive pointer.
+     */
+    i_ptr &operator=(const i_ptr &other) noexcept
+    {
+      i_ptr(other).swap(*this);
+      return *this;
+    }
+    /**
+     * @brief Move assignment operator to transfer ownership from another intrusive pointer.
+     *
+     * @param other The other intrusive pointer to move from.
+     * @return i_ptr& Reference to this intrusive pointer.
+     */
+    i_ptr &operator=(i_ptr &&other) noexcept
+    {
+      i_ptr(std::move(other)).swap(*this);
+      return *this;
+    }
+
+    /**
+     * @brief Retrieves the raw pointer to the managed object.
+     *
+     * @return T* Pointer to the managed object.
+     */
+    T *get() const noexcept { return ptr; }
+
+    /**
+     * @brief Overloaded arrow operator to access the managed object.
+     *
+     * @return T* Pointer to the managed object.
+     */
+    T *operator->() const noexcept { return ptr; }
+    /**
+     * @brief Overloaded dereference operator to access the managed object.
+     *
+     * @return T& Reference to the managed object.
+     */
+    T &operator*() const noexcept { return *ptr; }
+
+    /**
+     * @brief Conversion operator to check if the intrusive pointer is valid.
+     *
+     * @return bool True if the intrusive pointer is valid, false otherwise.
+     */
+    operator bool() const noexcept { return ptr != nullptr; }
+
+    /**
+     * @brief Returns the number of intrusive pointers owning the managed object.
+     *
+     * @return size_t The number of intrusive pointers owning the managed object.
+     */
+    [[nodiscard]] size_t use_count() const noexcept { return ptr ? ptr->use_count() : 0; }
+
+    /**
+     * @brief Releases the ownership of the managed object, if any.
+     */
+    void reset() noexcept { i_ptr().swap(*this); }
+    /**
+     * @brief Swaps the contents of this intrusive pointer with another.
+     *
+     * @param other The intrusive pointer to swap with.
+     */
+    void swap(i_ptr &other) noexcept { std::swap(ptr, other.ptr); }
+
+  private:
+    T *ptr;
+  };
+
+  /**
+   * @brief Creates an intrusive pointer to an object of type Tp.
+   *
+   * @tparam Tp The type of the object to create, deriving from `ref_counted`.
+   * @tparam Args The types of the arguments to pass to the constructor of Tp.
+   * @param args The arguments to pass to the constructor of Tp.
+   * @return i_ptr<Tp> An intrusive pointer to the newly created object of type Tp.
+   */
+  template <typename Tp, typename... Args>
+  i_ptr<Tp> make_i_ptr(Args &&...args) { return i_ptr<Tp>(new Tp(std::forward<Args>(args)...)); }
+
+  template <class T, class U>
+  inline bool operator==(i_ptr<T> const &a, i_ptr<U> const &b) noexcept { return a.get() == b.get(); }
   template <class T, class U>
-  inline bool operator!=(s_ptr<T> const &a, s_ptr<U> const &b) { return a.get() != b.get(); }
+  inline bool operator!=(i_ptr<T> const &a, i_ptr<U> const &b) noexcept { return a.get() != b.get(); }
 
   /**
    * @class ref_wrapper
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <utility>
+#include <cstddef>
+#include <cassert>
+
+namespace utils
+{
+  /**
+   * @brief Splits the `[0, count)` index range into `parts` contiguous sub-ranges of (almost) equal size.
+   *
+   * The first `count % parts` sub-ranges contain one element more than the remaining ones, so that the sizes of any two sub-ranges differ by at most one.
+   * Together with the ranking/unranking functions of `combinations` and `cartesian_product`, this allows to split a huge enumeration among several workers.
+   *
+   * @param count The total number of elements of the range.
+   * @param parts The number of sub-ranges.
+   * @param part The index of the requested sub-range, in `[0, parts)`.
+   * @return std::pair<std::size_t, std::size_t> The `[first, last)` bounds of the requested sub-range.
+   */
+  [[nodiscard]] inline std::pair<std::size_t, std::size_t> partition_range(const std::size_t count, const std::size_t parts, const std::size_t part) noexcept
+  {
+    assert(parts > 0 && part < parts);
+    const std::size_t size = count / parts;
+    const std::size_t rem = count % parts;
+    const std::size_t first = part * size + (part < rem ? part : rem);
+    return {first, first + size + (part < rem ? 1 : 0)};
+  }
+} // namespace utils
@@ -1,9 +1,66 @@
 #pragma once
 
 #include <string>
+#include <type_traits>
+#include <cassert>
+#include "instrumentation.hpp"
 
 namespace utils
 {
+  /**
+   * @brief Returns the number of trailing zero bits of a non-zero value, also during constant evaluation.
+   */
+  [[nodiscard]] constexpr int trailing_zeros(unsigned long long w) noexcept
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(w);
+#else
+    int c = 0;
+    for (; !(w & 1); w >>= 1)
+      ++c;
+    return c;
+#endif
+  }
+
+  /**
+   * @brief Computes the greatest common divisor of `|a|` and `|b|` through Stein's binary algorithm, which replaces the divisions with shifts and subtractions.
+   *
+   * The gcd with a power of two is the lowest set bit of the other value, so that it requires no iteration at all.
+   */
+  [[nodiscard]] constexpr INT_TYPE binary_gcd(INT_TYPE a, INT_TYPE b) noexcept
+  {
+    using uint_type = std::make_unsigned_t<INT_TYPE>;
+    uint_type u = a < 0 ? uint_type(0) - uint_type(a) : uint_type(a);
+    uint_type v = b < 0 ? uint_type(0) - uint_type(b) : uint_type(b);
+    if (u == 0)
+      return static_cast<INT_TYPE>(v);
+    if (v == 0)
+      return static_cast<INT_TYPE>(u);
+
+    UTILS_COUNT("rational.gcd");
+    const uint_type u_low = u & (uint_type(0) - u), v_low = v & (uint_type(0) - v); // the lowest set bits..
+    if (u == u_low || v == v_low)
+    {
+      UTILS_COUNT("rational.gcd_power_of_two");
+      return static_cast<INT_TYPE>(u_low < v_low ? u_low : v_low);
+    }
+
+    const int shift = trailing_zeros(u | v);
+    u >>= trailing_zeros(u);
+    do
+    {
+      v >>= trailing_zeros(v);
+      if (u > v)
+      {
+        const uint_type t = u;
+        u = v;
+        v = t;
+      }
+      v -= u;
+    } while (v);
+    return static_cast<INT_TYPE>(u << shift);
+  }
+
   class rational final
   {
   public:
@@ -12,71 +69,71 @@ namespace utils
     static const rational positive_infinite;
     static const rational negative_infinite;
 
-    rational() noexcept;
-    rational(INT_TYPE n) noexcept;
-    rational(INT_TYPE n, INT_TYPE d) noexcept;
-
-    [[nodiscard]] INT_TYPE numerator() const noexcept { return num; }
-    [[nodiscard]] INT_TYPE denominator() const noexcept { return den; }
-
-    friend bool is_integer(const rational &rhs) noexcept;
-    friend bool is_zero(const rational &rhs) noexcept;
-    friend bool is_positive(const rational &rhs) noexcept;
-    friend bool is_positive_or_zero(const rational &rhs) noexcept;
-    friend bool is_negative(const rational &rhs) noexcept;
-    friend bool is_negative_or_zero(const rational &rhs) noexcept;
-    friend bool is_infinite(const rational &rhs) noexcept;
-    friend bool is_positive_infinite(const rational &rhs) noexcept;
-    friend bool is_negative_infinite(const rational &rhs) noexcept;
-    friend double to_double(const rational &rhs) noexcept;
-
-    [[nodiscard]] bool operator!=(const rational &rhs) const noexcept;
-    [[nodiscard]] bool operator<(const rational &rhs) const noexcept;
-    [[nodiscard]] bool operator<=(const rational &rhs) const noexcept;
-    [[nodiscard]] bool operator==(const rational &rhs) const noexcept;
-    [[nodiscard]] bool operator>=(const rational &rhs) const noexcept;
-    [[nodiscard]] bool operator>(const rational &rhs) const noexcept;
-
-    [[nodiscard]] bool operator!=(const INT_TYPE &rhs) const noexcept;
-    [[nodiscard]] bool operator<(const INT_TYPE &rhs) const noexcept;
-    [[nodiscard]] bool operator<=(const INT_TYPE &rhs) const noexcept;
-    [[nodiscard]] bool operator==(const INT_TYPE &rhs) const noexcept;
-    [[nodiscard]] bool operator>=(const INT_TYPE &rhs) const noexcept;
-    [[nodiscard]] bool operator>(const INT_TYPE &rhs) const noexcept;
-
-    [[nodiscard]] rational operator+(const rational &rhs) const noexcept;
-    [[nodiscard]] rational operator-(const rational &rhs) const noexcept;
-    [[nodiscard]] rational operator*(const rational &rhs) const noexcept;
-    [[nodiscard]] rational operator/(const rational &rhs) const noexcept;
-
-    [[nodiscard]] rational operator+(const INT_TYPE &rhs) const noexcept;
-    [[nodiscard]] rational operator-(const INT_TYPE &rhs) const noexcept;
-    [[nodiscard]] rational operator*(const INT_TYPE &rhs) const noexcept;
-    [[nodiscard]] rational operator/(const INT_TYPE &rhs) const noexcept;
-
-    rational &operator+=(const rational &rhs) noexcept;
-    rational &operator-=(const rational &rhs) noexcept;
-    rational &operator*=(const rational &rhs) noexcept;
-    rational &operator/=(const rational &rhs) noexcept;
-
-    rational &operator+=(const INT_TYPE &rhs) noexcept;
-    rational &operator-=(const INT_TYPE &rhs) noexcept;
-    rational &operator*=(const INT_TYPE &rhs) noexcept;
-    rational &operator/=(const INT_TYPE &rhs) noexcept;
-
-    friend rational operator+(const INT_TYPE &lhs, const rational &rhs) noexcept;
-    friend rational operator-(const INT_TYPE &lhs, const rational &rhs) noexcept;
-    friend rational operator*(const INT_TYPE &lhs, const rational &rhs) noexcept;
-    friend rational operator/(const INT_TYPE &lhs, const rational &rhs) noexcept;
-
-    friend bool operator!=(const INT_TYPE &lhs, const rational &rhs) noexcept;
-    friend bool operator<(const INT_TYPE &lhs, const rational &rhs) noexcept;
-    friend bool operator<=(const INT_TYPE &lhs, const rational &rhs) noexcept;
-    friend bool operator==(const INT_TYPE &lhs, const rational &rhs) noexcept;
-    friend bool operator>=(const INT_TYPE &lhs, const rational &rhs) noexcept;
-    friend bool operator>(const INT_TYPE &lhs, const rational &rhs) noexcept;
-
-    [[nodiscard]] rational operator-() const noexcept;
+    constexpr rational() noexcept;
+    constexpr rational(INT_TYPE n) noexcept;
+    constexpr rational(INT_TYPE n, INT_TYPE d) noexcept;
+
+    [[nodiscard]] constexpr INT_TYPE numerator() const noexcept { return num; }
+    [[nodiscard]] constexpr INT_TYPE denominator() const noexcept { return den; }
+
+    friend constexpr bool is_integer(const rational &rhs) noexcept;
+    friend constexpr bool is_zero(const rational &rhs) noexcept;
+    friend constexpr bool is_positive(const rational &rhs) noexcept;
+    friend constexpr bool is_positive_or_zero(const rational &rhs) noexcept;
+    friend constexpr bool is_negative(const rational &rhs) noexcept;
+    friend constexpr bool is_negative_or_zero(const rational &rhs) noexcept;
+    friend constexpr bool is_infinite(const rational &rhs) noexcept;
+    friend constexpr bool is_positive_infinite(const rational &rhs) noexcept;
+    friend constexpr bool is_negative_infinite(const rational &rhs) noexcept;
+    friend constexpr double to_double(const rational &rhs) noexcept;
+
+    [[nodiscard]] constexpr bool operator!=(const rational &rhs) const noexcept;
+    [[nodiscard]] constexpr bool operator<(const rational &rhs) const noexcept;
+    [[nodiscard]] constexpr bool operator<=(const rational &rhs) const noexcept;
+    [[nodiscard]] constexpr bool operator==(const rational &rhs) const noexcept;
+    [[nodiscard]] constexpr bool operator>=(const rational &rhs) const noexcept;
+    [[nodiscard]] constexpr bool operator>(const rational &rhs) const noexcept;
+
+    [[nodiscard]] constexpr bool operator!=(const INT_TYPE &rhs) const noexcept;
+    [[nodiscard]] constexpr bool operator<(const INT_TYPE &rhs) const noexcept;
+    [[nodiscard]] constexpr bool operator<=(const INT_TYPE &rhs) const noexcept;
+    [[nodiscard]] constexpr bool operator==(const INT_TYPE &rhs) const noexcept;
+    [[nodiscard]] constexpr bool operator>=(const INT_TYPE &rhs) const noexcept;
+    [[nodiscard]] constexpr bool operator>(const INT_TYPE &rhs) const noexcept;
+
+    [[nodiscard]] constexpr rational operator+(const rational &rhs) const noexcept;
+    [[nodiscard]] constexpr rational operator-(const rational &rhs) const noexcept;
+    [[nodiscard]] constexpr rational operator*(const rational &rhs) const noexcept;
+    [[nodiscard]] constexpr rational operator/(const rational &rhs) const noexcept;
+
+    [[nodiscard]] constexpr rational operator+(const INT_TYPE &rhs) const noexcept;
+    [[nodiscard]] constexpr rational operator-(const INT_TYPE &rhs) const noexcept;
+    [[nodiscard]] constexpr rational operator*(const INT_TYPE &rhs) const noexcept;
+    [[nodiscard]] constexpr rational operator/(const INT_TYPE &rhs) const noexcept;
+
+    constexpr rational &operator+=(const rational &rhs) noexcept;
+    constexpr rational &operator-=(const rational &rhs) noexcept;
+    constexpr rational &operator*=(const rational &rhs) noexcept;
+    constexpr rational &operator/=(const rational &rhs) noexcept;
+
+    constexpr rational &operator+=(const INT_TYPE &rhs) noexcept;
+    constexpr rational &operator-=(const INT_TYPE &rhs) noexcept;
+    constexpr rational &operator*=(const INT_TYPE &rhs) noexcept;
+    constexpr rational &operator/=(const INT_TYPE &rhs) noexcept;
+
+    friend constexpr rational operator+(const INT_TYPE &lhs, const rational &rhs) noexcept;
+    friend constexpr rational operator-(const INT_TYPE &lhs, const rational &rhs) noexcept;
+    friend constexpr rational operator*(const INT_TYPE &lhs, const rational &rhs) noexcept;
+    friend constexpr rational operator/(const INT_TYPE &lhs, const rational &rhs) noexcept;
+
+    friend constexpr bool operator!=(const INT_TYPE &lhs, const rational &rhs) noexcept;
+    friend constexpr bool operator<(const INT_TYPE &lhs, const rational &rhs) noexcept;
+    friend constexpr bool operator<=(const INT_TYPE &lhs, const rational &rhs) noexcept;
+    friend constexpr bool operator==(const INT_TYPE &lhs, const rational &rhs) noexcept;
+    friend constexpr bool operator>=(const INT_TYPE &lhs, const rational &rhs) noexcept;
+    friend constexpr bool operator>(const INT_TYPE &lhs, const rational &rhs) noexcept;
+
+    [[nodiscard]] constexpr rational operator-() const noexcept;
 
     /**
      * @brief Computes the floor value of the given rational number.
@@ -86,7 +143,7 @@ namespace utils
      * @param rhs The rational number for which the floor value is to be computed.
      * @return INT_TYPE The floor value of the given rational number.
      */
-    friend INT_TYPE floor(const rational &rhs) noexcept;
+    friend constexpr INT_TYPE floor(const rational &rhs) noexcept;
     /**
      * @brief Computes the ceiling value of the given rational number.
      *
@@ -95,10 +152,18 @@ namespace utils
      * @param rhs The rational number for which the ceiling value is to be computed.
      * @return INT_TYPE The ceiling value of the given rational number.
      */
-    friend INT_TYPE ceil(const rational &rhs) noexcept;
+    friend constexpr INT_TYPE ceil(const rational &rhs) noexcept;
 
   private:
-    void normalize() noexcept;
+    struct canonical_t
+    {
+    };
+    /**
+     * @brief Constructs the rational `n/d` without normalizing it, for results which are already in canonical form (i.e., `d >= 0` and `gcd(n, d) == 1`).
+     */
+    constexpr rational(INT_TYPE n, INT_TYPE d, canonical_t) noexcept : num(n), den(d) {}
+
+    constexpr void normalize() noexcept;
 
     friend std::string to_string(const rational &rhs) noexcept;
 
@@ -107,28 +172,394 @@ namespace utils
     INT_TYPE den; // the denominator..
   };
 
-  [[nodiscard]] inline bool is_integer(const rational &rhs) noexcept { return rhs.den == 1; }
-  [[nodiscard]] inline bool is_zero(const rational &rhs) noexcept { return rhs.num == 0; }
-  [[nodiscard]] inline bool is_positive(const rational &rhs) noexcept { return rhs.num > 0; }
-  [[nodiscard]] inline bool is_positive_or_zero(const rational &rhs) noexcept { return rhs.num >= 0; }
-  [[nodiscard]] inline bool is_negative(const rational &rhs) noexcept { return rhs.num < 0; }
-  [[nodiscard]] inline bool is_negative_or_zero(const rational &rhs) noexcept { return rhs.num <= 0; }
-  [[nodiscard]] inline bool is_infinite(const rational &rhs) noexcept { return rhs.den == 0; }
-  [[nodiscard]] inline bool is_positive_infinite(const rational &rhs) noexcept { return is_positive(rhs) && is_infinite(rhs); }
-  [[nodiscard]] inline bool is_negative_infinite(const rational &rhs) noexcept { return is_negative(rhs) && is_infinite(rhs); }
-  [[nodiscard]] inline double to_double(const rational &rhs) noexcept { return static_cast<double>(rhs.num) / rhs.den; }
-
-  [[nodiscard]] inline rational operator+(const INT_TYPE &lhs, const rational &rhs) noexcept { return rational(lhs) + rhs; }
-  [[nodiscard]] inline rational operator-(const INT_TYPE &lhs, const rational &rhs) noexcept { return rational(lhs) - rhs; }
-  [[nodiscard]] inline rational operator*(const INT_TYPE &lhs, const rational &rhs) noexcept { return rational(lhs) * rhs; }
-  [[nodiscard]] inline rational operator/(const INT_TYPE &lhs, const rational &rhs) noexcept { return rational(lhs) / rhs; }
-
-  [[nodiscard]] inline bool operator!=(const INT_TYPE &lhs, const rational &rhs) noexcept { return rhs != lhs; }
-  [[nodiscard]] inline bool operator<(const INT_TYPE &lhs, const rational &rhs) noexcept { return rhs > lhs; }
-  [[nodiscard]] inline bool operator<=(const INT_TYPE &lhs, const rational &rhs) noexcept { return rhs >= lhs; }
-  [[nodiscard]] inline bool operator==(const INT_TYPE &lhs, const rational &rhs) noexcept { return rhs == lhs; }
-  [[nodiscard]] inline bool operator>=(const INT_TYPE &lhs, const rational &rhs) noexcept { return rhs <= lhs; }
-  [[nodiscard]] inline bool operator>(const INT_TYPE &lhs, const rational &rhs) noexcept { return rhs < lhs; }
+  [[nodiscard]] constexpr bool is_integer(const rational &rhs) noexcept { return rhs.den == 1; }
+  [[nodiscard]] constexpr bool is_zero(const rational &rhs) noexcept { return rhs.num == 0; }
+  [[nodiscard]] constexpr bool is_positive(const rational &rhs) noexcept { return rhs.num > 0; }
+  [[nodiscard]] constexpr bool is_positive_or_zero(const rational &rhs) noexcept { return rhs.num >= 0; }
+  [[nodiscard]] constexpr bool is_negative(const rational &rhs) noexcept { return rhs.num < 0; }
+  [[nodiscard]] constexpr bool is_negative_or_zero(const rational &rhs) noexcept { return rhs.num <= 0; }
+  [[nodiscard]] constexpr bool is_infinite(const rational &rhs) noexcept { return rhs.den == 0; }
+  [[nodiscard]] constexpr bool is_positive_infinite(const rational &rhs) noexcept { return is_positive(rhs) && is_infinite(rhs); }
+  [[nodiscard]] constexpr bool is_negative_infinite(const rational &rhs) noexcept { return is_negative(rhs) && is_infinite(rhs); }
+  [[nodiscard]] constexpr double to_double(const rational &rhs) noexcept { return static_cast<double>(rhs.num) / rhs.den; }
+
+  [[nodiscard]] constexpr rational operator+(const INT_TYPE &lhs, const rational &rhs) noexcept { return rational(lhs) + rhs; }
+  [[nodiscard]] constexpr rational operator-(const INT_TYPE &lhs, const rational &rhs) noexcept { return rational(lhs) - rhs; }
+  [[nodiscard]] constexpr rational operator*(const INT_TYPE &lhs, const rational &rhs) noexcept { return rational(lhs) * rhs; }
+  [[nodiscard]] constexpr rational operator/(const INT_TYPE &lhs, const rational &rhs) noexcept { return rational(lhs) / rhs; }
+
+  [[nodiscard]] constexpr bool operator!=(const INT_TYPE &lhs, const rational &rhs) noexcept { return rhs != lhs; }
+  [[nodiscard]] constexpr bool operator<(const INT_TYPE &lhs, const rational &rhs) noexcept { return rhs > lhs; }
+  [[nodiscard]] constexpr bool operator<=(const INT_TYPE &lhs, const rational &rhs) noexcept { return rhs >= lhs; }
+  [[nodiscard]] constexpr bool operator==(const INT_TYPE &lhs, const rational &rhs) noexcept { return rhs == lhs; }
+  [[nodiscard]] constexpr bool operator>=(const INT_TYPE &lhs, const rational &rhs) noexcept { return rhs <= lhs; }
+  [[nodiscard]] constexpr bool operator>(const INT_TYPE &lhs, const rational &rhs) noexcept { return rhs < lhs; }
+
+  constexpr rational::rational() noexcept : num(0), den(1) {}
+  constexpr rational::rational(INT_TYPE n) noexcept : num(n), den(1) {}
+  constexpr rational::rational(INT_TYPE n, INT_TYPE d) noexcept : num(n), den(d)
+  {
+    assert(n != 0 || d != 0);
+    normalize();
+  }
+
+  constexpr bool rational::operator!=(const rational &rhs) const noexcept { return num != rhs.num || den != rhs.den; }
+  constexpr bool rational::operator<(const rational &rhs) const noexcept { return (den == rhs.den) ? num < rhs.num : num * rhs.den < den * rhs.num; }
+  constexpr bool rational::operator<=(const rational &rhs) const noexcept { return num * rhs.den <= den * rhs.num; }
+  constexpr bool rational::operator==(const rational &rhs) const noexcept { return num == rhs.num && den == rhs.den; }
+  constexpr bool rational::operator>=(const rational &rhs) const noexcept { return num * rhs.den >= den * rhs.num; }
+  constexpr bool rational::operator>(const rational &rhs) const noexcept { return (den == rhs.den) ? num > rhs.num : num * rhs.den > den * rhs.num; }
+
+  constexpr bool rational::operator!=(const INT_TYPE &rhs) const noexcept { return num != rhs || den != 1; }
+  constexpr bool rational::operator<(const INT_TYPE &rhs) const noexcept { return num < den * rhs; }
+  constexpr bool rational::operator<=(const INT_TYPE &rhs) const noexcept { return num <= den * rhs; }
+  constexpr bool rational::operator==(const INT_TYPE &rhs) const noexcept { return num == rhs && den == 1; }
+  constexpr bool rational::operator>=(const INT_TYPE &rhs) const noexcept { return num >= den * rhs; }
+  constexpr bool rational::operator>(const INT_TYPE &rhs) const noexcept { return num > den * rhs; }
+
+  constexpr rational rational::operator+(const rational &rhs) const noexcept
+  {
+    assert(den != 0 || rhs.den != 0 || num == rhs.num); // inf + -inf or -inf + inf..
+
+    // special cases..
+    if (num == 0 || is_infinite(rhs))
+      return rhs;
+    if (rhs.num == 0 || is_infinite(*this))
+      return *this;
+    if (den == 1 && rhs.den == 1)
+      return rational(num + rhs.num);
+
+    if (den == rhs.den)
+    { // only the sum of the numerators and the common denominator can share a factor..
+      rational res(num + rhs.num, den, canonical_t{});
+      res.normalize();
+      return res;
+    }
+
+    const INT_TYPE g = binary_gcd(den, rhs.den);
+    if (g == 1) // with coprime denominators, the result is already in canonical form..
+      return rational(num * rhs.den + rhs.num * den, den * rhs.den, canonical_t{});
+
+    const INT_TYPE t = num * (rhs.den / g) + rhs.num * (den / g);
+    const INT_TYPE g2 = binary_gcd(t, g); // only the factors of `g` can be shared with the new numerator..
+    return rational(t / g2, (den / g) * (rhs.den / g2), canonical_t{});
+  }
+
+  constexpr rational rational::operator-(const rational &rhs) const noexcept { return operator+(-rhs); }
+
+  constexpr rational rational::operator*(const rational &rhs) const noexcept
+  {
+    assert(num != 0 || rhs.den != 0); // 0*inf..
+    assert(den != 0 || rhs.num != 0); // inf*0..
+
+    // special cases..
+    if (rhs == one)
+      return *this;
+    if (operator==(one))
+      return rhs;
+    if (den == 1 && rhs.den == 1)
+      return rational(num * rhs.num);
+    if (is_infinite(*this) || is_infinite(rhs))
+      return ((num >= 0 && rhs.num >= 0) || (num <= 0 && rhs.num <= 0)) ? positive_infinite : negative_infinite;
+
+    // the cross-reduced factors are coprime, so that the product is already in canonical form..
+    const INT_TYPE g1 = binary_gcd(num, rhs.den), g2 = binary_gcd(rhs.num, den);
+    return rational((num / g1) * (rhs.num / g2), (den / g2) * (rhs.den / g1), canonical_t{});
+  }
+
+  constexpr rational rational::operator/(const rational &rhs) const noexcept
+  {
+    assert(rhs.num != 0 || rhs.den != 0 || num == 0); // 0/0..
+    assert(rhs.num != 0 || rhs.den != 0 || den == 0); // inf/inf..
+
+    rational rec;
+    if (rhs.num >= 0)
+    {
+      rec.num = rhs.den;
+      rec.den = rhs.num;
+    }
+    else
+    {
+      rec.num = -rhs.den;
+      rec.den = -rhs.num;
+    }
+    return operator*(rec);
+  }
+
+  constexpr rational rational::operator+(const INT_TYPE &rhs) const noexcept
+  {
+    // special cases..
+    if (num == 0)
+      return rational(rhs);
+    if (rhs == 0 || is_infinite(*this))
+      return *this;
+    if (den == 1)
+      return rational(num + rhs);
+
+    rational res;
+    res.num = num + rhs * den;
+    res.den = den;
+    return res;
+  }
+
+  constexpr rational rational::operator-(const INT_TYPE &rhs) const noexcept { return operator+(-rhs); }
+
+  constexpr rational rational::operator*(const INT_TYPE &rhs) const noexcept
+  {
+    assert(den != 0 || rhs != 0); // inf*0..
+    assert(rhs != 0 || den != 0); // 0*inf..
+
+    // special cases..
+    if (rhs == 1)
+      return *this;
+    if (operator==(one))
+      return rational(rhs);
+    if (den == 1)
+      return rational(num * rhs);
+    if (is_infinite(*this))
+      return ((num >= 0 && rhs >= 0) || (num <= 0 && rhs <= 0)) ? positive_infinite : negative_infinite;
+
+    const INT_TYPE g = binary_gcd(rhs, den);
+    return rational(num * (rhs / g), den / g, canonical_t{});
+  }
+
+  constexpr rational rational::operator/(const INT_TYPE &rhs) const noexcept
+  {
+    assert(rhs != 0 || num == 0); // 0/0..
+    assert(rhs != 0 || den == 0); // inf/inf..
+
+    rational rec;
+    rec.num = 1;
+    rec.den = rhs;
+    if (rhs >= 0)
+    {
+      rec.num = 1;
+      rec.den = rhs;
+    }
+    else
+    {
+      rec.num = -1;
+      rec.den = -rhs;
+    }
+    return operator*(rec);
+  }
+
+  constexpr rational &rational::operator+=(const rational &rhs) noexcept
+  {
+    assert(den != 0 || rhs.den != 0 || num == rhs.num); // inf + -inf or -inf + inf..
+
+    // special cases..
+    if (num == 0 || is_infinite(rhs))
+    {
+      num = rhs.num;
+      den = rhs.den;
+      return *this;
+    }
+    if (rhs.num == 0 || is_infinite(*this))
+      return *this;
+    if (den == 1 && rhs.den == 1)
+    {
+      num += rhs.num;
+      return *this;
+    }
+
+    if (den == rhs.den)
+    { // only the sum of the numerators and the common denominator can share a factor..
+      num += rhs.num;
+      normalize();
+      return *this;
+    }
+
+    const INT_TYPE g = binary_gcd(den, rhs.den);
+    if (g == 1)
+    { // with coprime denominators, the result is already in canonical form..
+      num = num * rhs.den + rhs.num * den;
+      den *= rhs.den;
+      return *this;
+    }
+
+    const INT_TYPE t = num * (rhs.den / g) + rhs.num * (den / g);
+    const INT_TYPE g2 = binary_gcd(t, g); // only the factors of `g` can be shared with the new numerator..
+    num = t / g2;
+    den = (den / g) * (rhs.den / g2);
+    return *this;
+  }
+
+  constexpr rational &rational::operator-=(const rational &rhs) noexcept { return operator+=(-rhs); }
+
+  constexpr rational &rational::operator*=(const rational &rhs) noexcept
+  {
+    assert(num != 0 || rhs.den != 0); // 0*inf..
+    assert(den != 0 || rhs.num != 0); // inf*0..
+
+    // special cases..
+    if (rhs == one)
+      return *this;
+    if (operator==(one))
+    {
+      num = rhs.num;
+      den = rhs.den;
+      return *this;
+    }
+    if (den == 1 && rhs.den == 1)
+    {
+      num *= rhs.num;
+      return *this;
+    }
+    if (is_infinite(*this) || is_infinite(rhs))
+    {
+      num = ((num >= 0 && rhs.num >= 0) || (num <= 0 && rhs.num <= 0)) ? 1 : -1;
+      den = 0;
+      return *this;
+    }
+
+    // the cross-reduced factors are coprime, so that the product is already in canonical form..
+    const INT_TYPE g1 = binary_gcd(num, rhs.den), g2 = binary_gcd(rhs.num, den);
+    num = (num / g1) * (rhs.num / g2);
+    den = (den / g2) * (rhs.den / g1);
+    return *this;
+  }
+
+  constexpr rational &rational::operator/=(const rational &rhs) noexcept
+  {
+    assert(rhs.num != 0 || rhs.den != 0 || num == 0); // 0/0..
+    assert(rhs.num != 0 || rhs.den != 0 || den == 0); // inf/inf..
+
+    rational rec;
+    rec.num = rhs.den;
+    rec.den = rhs.num;
+    if (rhs.num >= 0)
+    {
+      rec.num = rhs.den;
+      rec.den = rhs.num;
+    }
+    else
+    {
+      rec.num = -rhs.den;
+      rec.den = -rhs.num;
+    }
+    return operator*=(rec);
+  }
+
+  constexpr rational &rational::operator+=(const INT_TYPE &rhs) noexcept
+  {
+    // special cases..
+    if (num == 0)
+    {
+      num = rhs;
+      return *this;
+    }
+    if (rhs == 0 || is_infinite(*this))
+      return *this;
+    if (den == 1)
+    {
+      num += rhs;
+      return *this;
+    }
+
+    num += rhs * den;
+    return *this;
+  }
+
+  constexpr rational &rational::operator-=(const INT_TYPE &rhs) noexcept { return operator+=(-rhs); }
+
+  constexpr rational &rational::operator*=(const INT_TYPE &rhs) noexcept
+  {
+    assert(den != 0 || rhs != 0); // inf*0..
+    assert(rhs != 0 || den != 0); // 0*inf..
+
+    // special cases..
+    if (rhs == 1)
+      return *this;
+    if (operator==(one))
+    {
+      num = rhs;
+      return *this;
+    }
+    if (is_infinite(*this))
+    {
+      num = ((num >= 0 && rhs >= 0) || (num <= 0 && rhs <= 0)) ? 1 : -1;
+      return *this;
+    }
+
+    const INT_TYPE g = binary_gcd(rhs, den);
+    num *= rhs / g;
+    den /= g;
+    return *this;
+  }
+
+  constexpr rational &rational::operator/=(const INT_TYPE &rhs) noexcept
+  {
+    assert(rhs != 0 || num == 0); // 0/0..
+    assert(rhs != 0 || den == 0); // inf/inf..
+
+    rational rec;
+    rec.num = 1;
+    rec.den = rhs;
+    if (rhs >= 0)
+    {
+      rec.num = 1;
+      rec.den = rhs;
+    }
+    else
+    {
+      rec.num = -1;
+      rec.den = -rhs;
+    }
+    return operator*=(rec);
+  }
+
+  constexpr rational rational::operator-() const noexcept
+  {
+    rational res(*this);
+    res.num = -res.num;
+    return res;
+  }
+
+  [[nodiscard]] constexpr INT_TYPE floor(const rational &rhs) noexcept
+  {
+    if (rhs.den == 1)
+      return rhs.num;
+    else if (rhs.num >= 0)
+      return rhs.num / rhs.den;
+    else
+      return rhs.num / rhs.den - 1;
+  }
+
+  [[nodiscard]] constexpr INT_TYPE ceil(const rational &rhs) noexcept
+  {
+    if (rhs.den == 1)
+      return rhs.num;
+    else if (rhs.num >= 0)
+      return rhs.num / rhs.den + 1;
+    else
+      return rhs.num / rhs.den;
+  }
+
+  constexpr void rational::normalize() noexcept
+  {
+    UTILS_COUNT("rational.normalize");
+    if (den != 1)
+    {
+      const INT_TYPE c_gcd = binary_gcd(num, den);
+      if (c_gcd != 1)
+      {
+        num /= c_gcd;
+        den /= c_gcd;
+      }
+      if (den < 0)
+      {
+        den = -den;
+        num = -num;
+      }
+    }
+  }
+
+  // being `constexpr`, the constants are available at compile time and do not depend on the static initialization order..
+  inline constexpr rational rational::zero{0};
+  inline constexpr rational rational::one{1};
+  inline constexpr rational rational::positive_infinite{1, 0};
+  inline constexpr rational rational::negative_infinite{-1, 0};
 
   [[nodiscard]] std::string to_string(const rational &rhs) noexcept;
 } // namespace utils
\ No newline at end of file
@@ -1,15 +1,58 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <cstring>
 
 namespace utils
 {
+  /**
+   * @brief A SHA-1 compression function, compressing `n_blocks` consecutive 64-byte blocks into the five words of `state`.
+   */
+  using sha1_compress_fn = void (*)(unsigned int *state, const unsigned char *blocks, size_t n_blocks);
+
+  /**
+   * @brief The implementations of the SHA-1 compression function.
+   */
+  enum class sha1_backend
+  {
+    portable, // plain C++..
+    ssse3,    // SSSE3 message schedule computed four words at a time..
+    sha_ni    // x86 SHA extensions..
+  };
+
+  /**
+   * @brief Returns the compression function of the given backend.
+   *
+   * @param backend The backend.
+   * @return sha1_compress_fn The compression function, or `nullptr` if the backend is not supported by the CPU.
+   */
+  [[nodiscard]] sha1_compress_fn get_sha1_compress(sha1_backend backend) noexcept;
+  /**
+   * @brief Returns the backend used by the `sha1` class.
+   *
+   * Unless overridden through `set_sha1_backend`, the fastest backend supported by the CPU is selected on the first use.
+   */
+  [[nodiscard]] sha1_backend get_sha1_backend() noexcept;
+  /**
+   * @brief Sets the backend used by the `sha1` class.
+   *
+   * @param backend The backend.
+   * @return bool True if the backend is supported by the CPU (and has been set), false otherwise.
+   */
+  bool set_sha1_backend(sha1_backend backend) noexcept;
+  /**
+   * @brief Compresses `n_blocks` consecutive 64-byte blocks into `state` through the current backend.
+   */
+  void sha1_compress(unsigned int *state, const unsigned char *blocks, size_t n_blocks) noexcept;
+
   /**
    * @class sha1
    * @brief Represents a SHA-1 hash algorithm implementation.
    *
    * The `sha1` class provides functionality to calculate the SHA-1 hash of a given input data.
+   * Data can be fed incrementally, in chunks of arbitrary size, through the `update` member function. Whole 64-byte blocks are compressed straight from the caller's buffer, while only the trailing partial block is buffered.
+   * The compression is dispatched, at runtime, to the fastest implementation supported by the CPU (see `sha1_backend`).
    * It supports obtaining the hash as both a 32-bit integer array and an 8-bit byte array.
    */
   class sha1
@@ -19,7 +62,85 @@ namespace utils
     typedef unsigned char digest_8[20];
     inline static unsigned int left_rotate(unsigned int value, size_t count) { return (value << count) ^ (value >> (32 - count)); }
 
-    sha1(std::string_view data) { process_bytes(data.data(), data.size()); }
+    sha1() = default;
+    sha1(std::string_view data) { update(data); }
+
+    /**
+     * @brief Feeds data to the hash computation.
+     *
+     * @param data Pointer to the data.
+     * @param len The number of bytes of the data.
+     */
+    void update(const void *const data, size_t len) noexcept
+    {
+      if (finalized || len == 0)
+        return;
+      const unsigned char *bytes = static_cast<const unsigned char *>(data);
+      byte_count += len;
+      if (block_byte_index)
+      { // we complete the buffered block..
+        const size_t fill = len < 64 - block_byte_index ? len : 64 - block_byte_index;
+        memcpy(block + block_byte_index, bytes, fill);
+        block_byte_index += fill;
+        bytes += fill;
+        len -= fill;
+        if (block_byte_index < 64)
+          return;
+        process_blocks(block, 1);
+        block_byte_index = 0;
+      }
+      // we compress the whole blocks straight from the caller's buffer..
+      process_blocks(bytes, len / 64);
+      bytes += len & ~size_t(63);
+      len &= 63;
+      // we buffer the trailing partial block..
+      if (len)
+        memcpy(block, bytes, len);
+      block_byte_index = len;
+    }
+    /**
+     * @brief Feeds data to the hash computation.
+     *
+     * @param data The data.
+     */
+    void update(std::string_view data) noexcept { update(data.data(), data.size()); }
+
+    /**
+     * @brief Completes the hash computation, padding the data fed so far.
+     *
+     * Once finalized, further calls to `update` are ignored and the digest can be retrieved any number of times.
+     */
+    void finalize() noexcept
+    {
+      if (finalized)
+        return;
+      unsigned char padded[128];
+      process_blocks(padded, pad(block, byte_count, padded));
+      block_byte_index = 0;
+      finalized = true;
+    }
+
+    /**
+     * @brief Pads the trailing partial block of a message, appending the `0x80` marker, the zeros and the 64-bit length of the message in bits.
+     *
+     * @param tail The trailing partial block of the message, made of its last `byte_count % 64` bytes.
+     * @param byte_count The length of the whole message in bytes.
+     * @param padded The buffer receiving the padded blocks.
+     * @return size_t The number of padded blocks (either one or two).
+     */
+    static size_t pad(const unsigned char *tail, size_t byte_count, unsigned char padded[128]) noexcept
+    {
+      const size_t tail_len = byte_count & 63;
+      const size_t n_blocks = tail_len < 56 ? 1 : 2; // the length needs 8 bytes after the marker..
+      const unsigned long long bit_count = static_cast<unsigned long long>(byte_count) * 8;
+      if (tail_len)
+        memcpy(padded, tail, tail_len);
+      padded[tail_len] = 0x80;
+      memset(padded + tail_len + 1, 0, n_blocks * 64 - 8 - tail_len - 1);
+      for (size_t i = 0; i < 8; ++i)
+        padded[n_blocks * 64 - 8 + i] = static_cast<unsigned char>((bit_count >> (56 - i * 8)) & 0xFF);
+      return n_blocks;
+    }
 
     /**
      * @brief Retrieves the digest value for a given SHA1 hash.
@@ -27,29 +148,9 @@ namespace utils
      * @param dig The SHA1 digest value to retrieve.
      * @return A pointer to the digest value.
      */
-    const unsigned int *get_digest(digest_32 dig)
+    const unsigned int *get_digest(digest_32 dig) noexcept
     {
-      size_t bit_count = byte_count * 8;
-      process_byte(0x80);
-      if (block_byte_index > 56)
-      {
-        while (block_byte_index != 0)
-          process_byte(0);
-        while (block_byte_index < 56)
-          process_byte(0);
-      }
-      else
-        while (block_byte_index < 56)
-          process_byte(0);
-      process_byte(0);
-      process_byte(0);
-      process_byte(0);
-      process_byte(0);
-      process_byte(static_cast<unsigned char>((bit_count >> 24) & 0xFF));
-      process_byte(static_cast<unsigned char>((bit_count >> 16) & 0xFF));
-      process_byte(static_cast<unsigned char>((bit_count >> 8) & 0xFF));
-      process_byte(static_cast<unsigned char>((bit_count) & 0xFF));
-
+      finalize();
       memcpy(dig, digest, 5 * sizeof(unsigned int));
       return dig;
     }
@@ -62,124 +163,28 @@ namespace utils
      * @param dig The digest for which to retrieve the bytes.
      * @return A pointer to the bytes of the digest.
      */
-    const unsigned char *get_digest_bytes(digest_8 dig)
+    const unsigned char *get_digest_bytes(digest_8 dig) noexcept
     {
       digest_32 d32;
       get_digest(d32);
-      size_t di = 0;
-      dig[di++] = ((d32[0] >> 24) & 0xFF);
-      dig[di++] = ((d32[0] >> 16) & 0xFF);
-      dig[di++] = ((d32[0] >> 8) & 0xFF);
-      dig[di++] = ((d32[0]) & 0xFF);
-
-      dig[di++] = ((d32[1] >> 24) & 0xFF);
-      dig[di++] = ((d32[1] >> 16) & 0xFF);
-      dig[di++] = ((d32[1] >> 8) & 0xFF);
-      dig[di++] = ((d32[1]) & 0xFF);
-
-      dig[di++] = ((d32[2] >> 24) & 0xFF);
-      dig[di++] = ((d32[2] >> 16) & 0xFF);
-      dig[di++] = ((d32[2] >> 8) & 0xFF);
-      dig[di++] = ((d32[2]) & 0xFF);
-
-      dig[di++] = ((d32[3] >> 24) & 0xFF);
-      dig[di++] = ((d32[3] >> 16) & 0xFF);
-      dig[di++] = ((d32[3] >> 8) & 0xFF);
-      dig[di++] = ((d32[3]) & 0xFF);
-
-      dig[di++] = ((d32[4] >> 24) & 0xFF);
-      dig[di++] = ((d32[4] >> 16) & 0xFF);
-      dig[di++] = ((d32[4] >> 8) & 0xFF);
-      dig[di++] = ((d32[4]) & 0xFF);
-      return dig;
-    }
-
-  private:
-    void process_bytes(const void *const data, size_t len)
-    {
-      const unsigned char *blck = static_cast<const unsigned char *>(data);
-      process_block(blck, blck + len);
-    }
-
-    void process_byte(unsigned char octet)
-    {
-      block[block_byte_index++] = octet;
-      ++byte_count;
-      if (block_byte_index == 64)
-      {
-        block_byte_index = 0;
-        process_block();
-      }
-    }
-
-    void process_block(const void *const start, const void *const end)
-    {
-      const unsigned char *begin = static_cast<const unsigned char *>(start);
-      const unsigned char *finish = static_cast<const unsigned char *>(end);
-      while (begin != finish)
+      for (size_t i = 0; i < 5; ++i)
       {
-        process_byte(*begin);
-        begin++;
+        dig[i * 4 + 0] = ((d32[i] >> 24) & 0xFF);
+        dig[i * 4 + 1] = ((d32[i] >> 16) & 0xFF);
+        dig[i * 4 + 2] = ((d32[i] >> 8) & 0xFF);
+        dig[i * 4 + 3] = ((d32[i]) & 0xFF);
       }
+      return dig;
     }
 
-    void process_block()
+  private:
+    /**
+     * @brief Compresses `n_blocks` consecutive 64-byte blocks into the digest.
+     */
+    void process_blocks(const unsigned char *blocks, size_t n_blocks) noexcept
     {
-      unsigned int w[80];
-      for (size_t i = 0; i < 16; i++)
-      {
-        w[i] = (block[i * 4 + 0] << 24);
-        w[i] |= (block[i * 4 + 1] << 16);
-        w[i] |= (block[i * 4 + 2] << 8);
-        w[i] |= (block[i * 4 + 3]);
-      }
-      for (size_t i = 16; i < 80; i++)
-        w[i] = left_rotate((w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16]), 1);
-
-      unsigned int a = digest[0];
-      unsigned int b = digest[1];
-      unsigned int c = digest[2];
-      unsigned int d = digest[3];
-      unsigned int e = digest[4];
-
-      for (std::size_t i = 0; i < 80; ++i)
-      {
-        unsigned int f = 0;
-        unsigned int k = 0;
-
-        if (i < 20)
-        {
-          f = (b & c) | (~b & d);
-          k = 0x5A827999;
-        }
-        else if (i < 40)
-        {
-          f = b ^ c ^ d;
-          k = 0x6ED9EBA1;
-        }
-        else if (i < 60)
-        {
-          f = (b & c) | (b & d) | (c & d);
-          k = 0x8F1BBCDC;
-        }
-        else
-        {
-          f = b ^ c ^ d;
-          k = 0xCA62C1D6;
-        }
-        unsigned int temp = left_rotate(a, 5) + f + e + k + w[i];
-        e = d;
-        d = c;
-        c = left_rotate(b, 30);
-        b = a;
-        a = temp;
-      }
-
-      digest[0] += a;
-      digest[1] += b;
-      digest[2] += c;
-      digest[3] += d;
-      digest[4] += e;
+      if (n_blocks)
+        sha1_compress(digest, blocks, n_blocks);
     }
 
   private:
@@ -187,5 +192,40 @@ namespace utils
     unsigned char block[64];
     size_t block_byte_index{0};
     size_t byte_count{0};
+    bool finalized{false};
+  };
+
+  /**
+   * @brief A function computing the SHA-1 digests of `count` independent messages.
+   */
+  using sha1_batch_fn = void (*)(const std::string_view *messages, size_t count, sha1::digest_8 *digests);
+
+  /**
+   * @brief The implementations of the batched SHA-1 hashing.
+   */
+  enum class sha1_batch_backend
+  {
+    serial, // one message after the other, through the `sha1` class..
+    avx2,   // eight messages at a time, one per 32-bit lane..
+    avx512  // sixteen messages at a time, one per 32-bit lane..
   };
+
+  /**
+   * @brief Returns the batched hashing function of the given backend.
+   *
+   * @param backend The backend.
+   * @return sha1_batch_fn The batched hashing function, or `nullptr` if the backend is not supported by the CPU.
+   */
+  [[nodiscard]] sha1_batch_fn get_sha1_batch(sha1_batch_backend backend) noexcept;
+
+  /**
+   * @brief Computes the SHA-1 digests of many independent messages.
+   *
+   * The messages are hashed in parallel, one per SIMD lane, through the widest backend supported by the CPU. Whenever a message is exhausted, its lane is refilled with the next pending message, so that messages of different lengths keep all the lanes busy.
+   *
+   * @param messages The messages to hash.
+   * @param count The number of messages.
+   * @param digests The buffer receiving the `count` digests, in the same order as the messages.
+   */
+  void sha1_batch(const std::string_view *messages, size_t count, sha1::digest_8 *digests) noexcept;
 } // namespace utils
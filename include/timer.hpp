@@ -1,22 +1,178 @@
 #pragma once
 
 #include <functional>
-#include <atomic>
+#include <unordered_map>
+#include <condition_variable>
+#include <cstdint>
+#include <array>
+#include <chrono>
 #include <thread>
 #include <mutex>
 
 namespace utils
 {
+  /**
+   * @brief The policy applied to a periodic timer whose callback overruns its period.
+   */
+  enum class overrun_policy
+  {
+    catch_up, // the missed ticks are executed back-to-back until the timer catches up..
+    skip,     // the missed ticks are dropped and the timer resumes at the next tick..
+    coalesce  // the missed ticks are collapsed into a single immediate execution..
+  };
+
+  /**
+   * @brief The latency statistics of a timer.
+   */
+  struct timer_stats
+  {
+    static constexpr size_t histogram_size = 16;
+
+    size_t ticks = 0;                                        // the number of executions of the callback..
+    size_t overruns = 0;                                     // the number of executions which ended after the following tick was due..
+    size_t missed_ticks = 0;                                 // the number of ticks dropped by the `skip` and `coalesce` policies..
+    std::chrono::microseconds last_jitter{0};                // the delay of the last execution with respect to its tick..
+    std::chrono::microseconds max_jitter{0};                 // the maximum delay of an execution with respect to its tick..
+    std::chrono::microseconds total_jitter{0};               // the sum of the delays of the executions with respect to their ticks..
+    std::chrono::microseconds max_duration{0};               // the maximum duration of the callback..
+    std::array<size_t, histogram_size> duration_histogram{}; // the `i`-th bucket counts the callbacks lasting less than 2^i microseconds (the last one counts all the longer ones)..
+
+    /**
+     * @brief Returns the mean delay of the executions with respect to their ticks.
+     */
+    [[nodiscard]] std::chrono::microseconds mean_jitter() const noexcept { return ticks ? total_jitter / static_cast<std::chrono::microseconds::rep>(ticks) : std::chrono::microseconds(0); }
+  };
+
+  /**
+   * @brief A hashed hierarchical timer wheel.
+   *
+   * The timer wheel drives any number of one-shot and periodic timers from a single thread.
+   * Time is discretized into ticks of `resolution` milliseconds. Timers expiring within the next 256 ticks are hashed into the slots of the first level of the wheel, while farther timers are hashed into the coarser slots of the upper levels and are cascaded down as time advances.
+   * Each slot is an intrusive list of timers, so that both scheduling and cancelling a timer take constant time.
+   *
+   * Callbacks are executed, one at a time, on the thread of the wheel. Long running callbacks, hence, delay the other timers of the same wheel.
+   */
+  class timer_wheel final
+  {
+  public:
+    using timer_id = std::size_t;
+
+    /**
+     * @brief Constructs a timer wheel and starts its thread.
+     *
+     * @param resolution The duration of each tick of the wheel in milliseconds.
+     */
+    timer_wheel(const size_t &resolution = 1);
+    ~timer_wheel();
+
+    timer_wheel(const timer_wheel &) = delete;
+    timer_wheel &operator=(const timer_wheel &) = delete;
+
+    /**
+     * @brief Schedules a new timer.
+     *
+     * @param delay The delay, in milliseconds, before the first execution of the callback.
+     * @param f The callback function to be executed when the timer expires.
+     * @param period The period, in milliseconds, of the subsequent executions of the callback. A zero period schedules a one-shot timer.
+     * @param policy The policy applied when the callback overruns the period of the timer.
+     * @return timer_id The identifier of the new timer.
+     */
+    [[nodiscard]] timer_id schedule(const size_t &delay, std::function<void(void)> f, const size_t &period = 0, const overrun_policy &policy = overrun_policy::catch_up);
+    /**
+     * @brief Cancels a timer.
+     *
+     * If the callback of the timer is being executed by another thread, this function waits for its completion, so that the callback is never executed after this function returns.
+     *
+     * @param id The identifier of the timer to cancel.
+     * @return bool True if the timer was scheduled, false otherwise.
+     */
+    bool cancel(const timer_id &id);
+
+    /**
+     * @brief Returns the latency statistics of a scheduled timer.
+     *
+     * @param id The identifier of the timer.
+     * @return timer_stats The statistics of the timer, or empty statistics if the timer is not scheduled.
+     */
+    [[nodiscard]] timer_stats get_stats(const timer_id &id);
+
+    /**
+     * @brief Returns the number of scheduled timers.
+     */
+    [[nodiscard]] size_t size();
+
+    /**
+     * @brief Returns the timer wheel shared by all the timers which are not explicitly bound to a wheel.
+     */
+    [[nodiscard]] static timer_wheel &get_default();
+
+  private:
+    struct entry
+    {
+      timer_id id;                   // the identifier of the timer..
+      uint64_t expires;              // the tick at which the timer expires..
+      uint64_t period;               // the period of the timer in ticks (zero for one-shot timers)..
+      std::function<void(void)> fun; // the callback function..
+      overrun_policy policy;         // the policy applied when the callback overruns the period..
+      timer_stats stats{};           // the latency statistics of the timer..
+      entry *next = nullptr;         // the next timer in the same slot..
+      entry **pprev = nullptr;       // the link pointing to this timer..
+      bool in_first_level = false;   // whether the timer is in the first level of the wheel..
+      bool cancelled = false;        // whether the timer has been cancelled while executing..
+    };
+
+    void add(entry &e) noexcept;
+    void unlink(entry &e) noexcept;
+    void cascade(const size_t &level) noexcept;
+    void step() noexcept;
+    void reschedule(entry &e) noexcept;
+    void run();
+
+    [[nodiscard]] uint64_t ticks(const size_t &ms) const noexcept { return (ms + resolution.count() - 1) / resolution.count(); }
+    [[nodiscard]] uint64_t now_tick() const noexcept { return static_cast<uint64_t>((std::chrono::steady_clock::now() - origin) / resolution); }
+
+  private:
+    static constexpr size_t root_bits = 8;  // the number of bits indexing the first level of the wheel..
+    static constexpr size_t level_bits = 6; // the number of bits indexing each of the upper levels of the wheel..
+    static constexpr size_t levels = 4;     // the number of upper levels of the wheel..
+
+    const std::chrono::milliseconds resolution;                       // the duration of each tick..
+    const std::chrono::steady_clock::time_point origin;               // the time of the tick zero..
+    uint64_t current = 0;                                             // the next tick to be processed..
+    std::array<entry *, 1 << root_bits> root{};                       // the slots of the first level of the wheel..
+    std::array<std::array<entry *, 1 << level_bits>, levels> upper{}; // the slots of the upper levels of the wheel..
+    size_t root_size = 0;                                             // the number of timers in the first level of the wheel..
+    entry *pending = nullptr;                                         // the expired timers waiting for their execution..
+    std::unordered_map<timer_id, entry> entries;                      // the scheduled timers..
+    timer_id next_id = 1;                                             // the identifier of the next timer..
+    timer_id executing = 0;                                           // the identifier of the timer being executed, if any..
+    bool running = true;
+    std::mutex mtx;
+    std::condition_variable cv;      // notified when the wheel changes..
+    std::condition_variable done_cv; // notified when a callback completes..
+    std::thread th;
+  };
+
   class timer final
   {
   public:
     /**
-     * @brief Constructs a timer object.
+     * @brief Constructs a timer object driven by the default timer wheel.
      *
      * @param tick_dur The duration of each tick in milliseconds.
      * @param f A callback function to be executed on each tick.
+     * @param policy The policy applied when the callback overruns the tick duration.
      */
-    timer(const size_t &tick_dur, std::function<void(void)> f);
+    timer(const size_t &tick_dur, std::function<void(void)> f, const overrun_policy &policy = overrun_policy::catch_up);
+    /**
+     * @brief Constructs a timer object driven by the given timer wheel.
+     *
+     * @param wheel The timer wheel driving the timer.
+     * @param tick_dur The duration of each tick in milliseconds.
+     * @param f A callback function to be executed on each tick.
+     * @param policy The policy applied when the callback overruns the tick duration.
+     */
+    timer(timer_wheel &wheel, const size_t &tick_dur, std::function<void(void)> f, const overrun_policy &policy = overrun_policy::catch_up);
     ~timer() { stop(); }
 
     /**
@@ -28,12 +184,17 @@ namespace utils
      */
     void stop();
 
+    /**
+     * @brief Returns the latency statistics of the timer since it was last started.
+     */
+    [[nodiscard]] timer_stats get_stats();
+
   private:
+    timer_wheel &wheel;            // the timer wheel driving this timer..
     const size_t tick_duration;    // the duration of each tick in milliseconds..
     std::function<void(void)> fun; // the callback function to be executed
-    std::chrono::steady_clock::time_point tick_time;
-    std::atomic<bool> executing;
-    std::thread th;
+    const overrun_policy policy;   // the policy applied when the callback overruns the tick duration..
+    timer_wheel::timer_id id = 0;  // the identifier of the timer within the wheel, if started..
     std::mutex mtx;
   };
 } // namespace utils
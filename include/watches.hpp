@@ -0,0 +1,158 @@
+#pragma once
+
+#include "bool.hpp"
+#include <algorithm>
+
+namespace utils
+{
+  /**
+   * @brief A watch of a clause, stored in the watch list of one of its two watched literals.
+   *
+   * The blocker is another literal of the clause: whenever it is true, the clause is satisfied and the propagation skips it without touching the clause.
+   *
+   * @tparam Ref The type of the references to the clauses.
+   */
+  template <typename Ref>
+  struct watcher
+  {
+    Ref clause;  // the watching clause..
+    lit blocker; // a literal of the clause which, when true, satisfies the clause..
+  };
+
+  /**
+   * @brief The outcome of visiting a watch during the propagation.
+   */
+  enum class watch_action
+  {
+    keep,   // the watch stays in the list..
+    remove, // the watch leaves the list, since the clause now watches another literal..
+    stop    // the watch, and all the following ones, stay in the list, and the visit stops (e.g., on a conflict)..
+  };
+
+  /**
+   * @class watch_lists
+   * @brief The two-watched-literal watch lists of a set of clauses.
+   *
+   * Each clause watches two of its literals and is stored, together with an inline blocker literal, in the list of the negation of each watched literal, so that the propagation of a literal `p` only visits the list of `p`.
+   * The lists are contiguous vectors, indexed by `index(lit)` through a `lit_map`, so that the propagation scans them without pointer chasing nor hashing.
+   *
+   * @tparam Ref The type of the references to the clauses.
+   */
+  template <typename Ref>
+  class watch_lists
+  {
+  public:
+    using list = std::vector<watcher<Ref>>;
+
+    /**
+     * @brief Constructs the (empty) watch lists of the literals of `n_vars` variables.
+     */
+    explicit watch_lists(size_t n_vars = 0) : lists(n_vars) {}
+
+    /**
+     * @brief Returns the number of variables whose literals have a watch list.
+     */
+    [[nodiscard]] size_t vars() const noexcept { return lists.vars(); }
+    /**
+     * @brief Extends the watch lists to the literals of `n_vars` variables.
+     */
+    void resize(size_t n_vars) { lists.resize(n_vars); }
+    /**
+     * @brief Extends the watch lists to the literals of a new variable, returning the variable.
+     */
+    var add_var() { return lists.add_var(); }
+
+    /**
+     * @brief Makes a clause watch the literal `p`, that is, the clause is visited when `!p` is propagated.
+     *
+     * @param p The watched literal.
+     * @param clause The watching clause.
+     * @param blocker Another literal of the clause.
+     */
+    void watch(const lit &p, const Ref &clause, const lit &blocker) { lists[!p].push_back({clause, blocker}); }
+    /**
+     * @brief Stops a clause from watching the literal `p`.
+     *
+     * @return bool True if the clause was watching the literal, false otherwise.
+     */
+    bool unwatch(const lit &p, const Ref &clause) noexcept
+    {
+      auto &l = lists[!p];
+      for (size_t i = 0; i < l.size(); ++i)
+        if (l[i].clause == clause)
+        {
+          l.erase(l.begin() + i);
+          return true;
+        }
+      return false;
+    }
+
+    /**
+     * @brief Returns the watches visited when the literal `p` is propagated.
+     */
+    [[nodiscard]] list &operator[](const lit &p) noexcept { return lists[p]; }
+    [[nodiscard]] const list &operator[](const lit &p) const noexcept { return lists[p]; }
+
+    /**
+     * @brief Visits the watches of the literal `p`, compacting its list in place as watches are removed.
+     *
+     * The visitor may add watches to the lists of other literals, but not to the list of `p`.
+     *
+     * @param p The propagated literal.
+     * @param values The current assignment, used to skip the watches whose blocker is true.
+     * @param f The visitor, called as `f(watcher<Ref> &)` and returning a `watch_action`.
+     * @return bool False if the visit was stopped by the visitor, true otherwise.
+     */
+    template <typename F>
+    bool propagate(const lit &p, const lbool_vector &values, F &&f)
+    {
+      auto &l = lists[p];
+      auto i = l.begin(), j = l.begin();
+      const auto end = l.end();
+      while (i != end)
+      {
+        if (values.value(i->blocker) == True)
+        { // the clause is satisfied, so we leave it alone..
+          *j++ = *i++;
+          continue;
+        }
+        switch (f(*i))
+        {
+        case watch_action::keep:
+          *j++ = *i++;
+          break;
+        case watch_action::remove:
+          ++i;
+          break;
+        case watch_action::stop:
+          j = std::copy(i, end, j);
+          l.erase(j, end);
+          return false;
+        }
+      }
+      l.erase(j, end);
+      return true;
+    }
+
+    /**
+     * @brief Rewrites the clause references of all the watches, as after a relocation of the clauses.
+     *
+     * @param f The function updating, in place, each clause reference, and returning false if the watch has to be dropped (e.g., since its clause has been removed).
+     */
+    template <typename F>
+    void relocate(F &&f)
+    {
+      for (auto &l : lists)
+      {
+        size_t j = 0;
+        for (auto &w : l)
+          if (f(w.clause))
+            l[j++] = w;
+        l.resize(j);
+      }
+    }
+
+  private:
+    lit_map<list> lists; // the watch lists, indexed by the propagated literal..
+  };
+} // namespace utils
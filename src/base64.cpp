@@ -0,0 +1,417 @@
+#include "base64.hpp"
+#include "cpu_features.hpp"
+#include <atomic>
+#include <algorithm>
+#include <cstring>
+#include <istream>
+#include <ostream>
+
+#ifdef UTILS_X86
+#include <immintrin.h>
+#endif
+
+namespace utils
+{
+    static constexpr char standard_chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    static constexpr char url_chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+    /**
+     * Maps each character to its 6-bit value, or to `0xFF` if it does not belong to the alphabet, so that the validity of a whole input can be checked by OR-ing the values.
+     */
+    struct decode_table
+    {
+        constexpr decode_table(const char *chars) : values{}
+        {
+            for (size_t i = 0; i < 256; ++i)
+                values[i] = 0xFF;
+            for (size_t i = 0; i < 64; ++i)
+                values[static_cast<unsigned char>(chars[i])] = static_cast<unsigned char>(i);
+        }
+
+        unsigned char values[256];
+    };
+    static constexpr decode_table standard_table(standard_chars);
+    static constexpr decode_table url_table(url_chars);
+
+    /**
+     * The SIMD kernels process the bulk of the input and return the number of consumed bytes (or characters), leaving the tail to the scalar code.
+     */
+    using encode_kernel = size_t (*)(const unsigned char *input, size_t len, char *output, const char *chars);
+    using decode_kernel = size_t (*)(const char *input, size_t len, unsigned char *output, const char *chars, bool &invalid);
+
+    static size_t encode_portable(const unsigned char *, size_t, char *, const char *) { return 0; }
+    static size_t decode_portable(const char *, size_t, unsigned char *, const char *, bool &) { return 0; }
+
+#ifdef UTILS_X86
+    /**
+     * Spreads each group of three bytes over four bytes, each holding six bits, and maps them to the characters of the alphabet.
+     * The mapping adds to each 6-bit value the offset of its range ('A'..'Z', 'a'..'z', '0'..'9', and the last two characters), looked up through a shuffle.
+     */
+    UTILS_TARGET("ssse3")
+    static inline __m128i encode_block(__m128i in, __m128i offsets) noexcept
+    {
+        in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+        const __m128i t0 = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0FC0FC00)), _mm_set1_epi32(0x04000040));
+        const __m128i t1 = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003F03F0)), _mm_set1_epi32(0x01000010));
+        const __m128i indices = _mm_or_si128(t0, t1);
+
+        // 0..25 -> 13, 26..51 -> 0, 52..61 -> 1..10, 62 -> 11, 63 -> 12..
+        __m128i range = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+        range = _mm_or_si128(range, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), indices), _mm_set1_epi8(13)));
+        return _mm_add_epi8(indices, _mm_shuffle_epi8(offsets, range));
+    }
+
+    UTILS_TARGET("ssse3")
+    static inline __m128i encode_offsets(const char *chars) noexcept { return _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, static_cast<char>(chars[62] - 62), static_cast<char>(chars[63] - 63), 'A', 0, 0); }
+
+    UTILS_TARGET("ssse3")
+    static size_t encode_ssse3(const unsigned char *input, size_t len, char *output, const char *chars)
+    {
+        const __m128i offsets = encode_offsets(chars);
+        size_t i = 0;
+        for (; i + 16 <= len; i += 12, output += 16) // the loads read four bytes past the consumed ones..
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(output), encode_block(_mm_loadu_si128(reinterpret_cast<const __m128i *>(input + i)), offsets));
+        return i;
+    }
+
+    /**
+     * Maps each character to its 6-bit value through range comparisons, returning in `valid` a mask of the characters belonging to the alphabet.
+     * Bytes above 0x7F compare as negative, hence fall outside all the ranges.
+     */
+    UTILS_TARGET("ssse3")
+    static inline __m128i decode_values(__m128i c, char c62, char c63, __m128i &valid) noexcept
+    {
+        const __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('A' - 1)), _mm_cmpgt_epi8(_mm_set1_epi8('Z' + 1), c));
+        const __m128i lower = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('a' - 1)), _mm_cmpgt_epi8(_mm_set1_epi8('z' + 1), c));
+        const __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)), _mm_cmpgt_epi8(_mm_set1_epi8('9' + 1), c));
+        const __m128i is62 = _mm_cmpeq_epi8(c, _mm_set1_epi8(c62));
+        const __m128i is63 = _mm_cmpeq_epi8(c, _mm_set1_epi8(c63));
+        valid = _mm_or_si128(_mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(digit, is62)), is63);
+
+        __m128i shift = _mm_and_si128(upper, _mm_set1_epi8(-'A'));
+        shift = _mm_or_si128(shift, _mm_and_si128(lower, _mm_set1_epi8(26 - 'a')));
+        shift = _mm_or_si128(shift, _mm_and_si128(digit, _mm_set1_epi8(52 - '0')));
+        shift = _mm_or_si128(shift, _mm_and_si128(is62, _mm_set1_epi8(static_cast<char>(62 - c62))));
+        shift = _mm_or_si128(shift, _mm_and_si128(is63, _mm_set1_epi8(static_cast<char>(63 - c63))));
+        return _mm_add_epi8(c, shift);
+    }
+
+    /**
+     * Packs each group of four 6-bit values into three bytes, placed in the first 12 bytes of the result.
+     */
+    UTILS_TARGET("ssse3")
+    static inline __m128i decode_pack(__m128i values) noexcept
+    {
+        const __m128i ab_cd = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+        const __m128i abcd = _mm_madd_epi16(ab_cd, _mm_set1_epi32(0x00011000));
+        return _mm_shuffle_epi8(abcd, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+    }
+
+    UTILS_TARGET("ssse3")
+    static size_t decode_ssse3(const char *input, size_t len, unsigned char *output, const char *chars, bool &invalid)
+    {
+        __m128i all_valid = _mm_set1_epi8(-1);
+        size_t i = 0;
+        for (; i + 24 <= len; i += 16, output += 12) // the stores write four bytes past the decoded ones..
+        {
+            __m128i valid;
+            const __m128i values = decode_values(_mm_loadu_si128(reinterpret_cast<const __m128i *>(input + i)), chars[62], chars[63], valid);
+            all_valid = _mm_and_si128(all_valid, valid);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(output), decode_pack(values));
+        }
+        invalid |= _mm_movemask_epi8(all_valid) != 0xFFFF;
+        return i;
+    }
+
+    UTILS_TARGET("avx2")
+    static size_t encode_avx2(const unsigned char *input, size_t len, char *output, const char *chars)
+    {
+        const __m256i offsets = _mm256_broadcastsi128_si256(encode_offsets(chars));
+        const __m256i spread = _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10, 1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+        size_t i = 0;
+        for (; i + 28 <= len; i += 24, output += 32) // each lane gets 12 bytes, the loads read four bytes past them..
+        {
+            const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input + i));
+            const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input + i + 12));
+            const __m256i in = _mm256_shuffle_epi8(_mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1), spread);
+            const __m256i t0 = _mm256_mulhi_epu16(_mm256_and_si256(in, _mm256_set1_epi32(0x0FC0FC00)), _mm256_set1_epi32(0x04000040));
+            const __m256i t1 = _mm256_mullo_epi16(_mm256_and_si256(in, _mm256_set1_epi32(0x003F03F0)), _mm256_set1_epi32(0x01000010));
+            const __m256i indices = _mm256_or_si256(t0, t1);
+
+            __m256i range = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+            range = _mm256_or_si256(range, _mm256_and_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices), _mm256_set1_epi8(13)));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(output), _mm256_add_epi8(indices, _mm256_shuffle_epi8(offsets, range)));
+        }
+        return i;
+    }
+
+    UTILS_TARGET("avx2")
+    static size_t decode_avx2(const char *input, size_t len, unsigned char *output, const char *chars, bool &invalid)
+    {
+        const char c62 = chars[62], c63 = chars[63];
+        __m256i all_valid = _mm256_set1_epi8(-1);
+        size_t i = 0;
+        for (; i + 44 <= len; i += 32, output += 24) // the stores write eight bytes past the decoded ones..
+        {
+            const __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(input + i));
+            const __m256i upper = _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8('A' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), c));
+            const __m256i lower = _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8('a' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), c));
+            const __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8('0' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), c));
+            const __m256i is62 = _mm256_cmpeq_epi8(c, _mm256_set1_epi8(c62));
+            const __m256i is63 = _mm256_cmpeq_epi8(c, _mm256_set1_epi8(c63));
+            all_valid = _mm256_and_si256(all_valid, _mm256_or_si256(_mm256_or_si256(_mm256_or_si256(upper, lower), _mm256_or_si256(digit, is62)), is63));
+
+            __m256i shift = _mm256_and_si256(upper, _mm256_set1_epi8(-'A'));
+            shift = _mm256_or_si256(shift, _mm256_and_si256(lower, _mm256_set1_epi8(26 - 'a')));
+            shift = _mm256_or_si256(shift, _mm256_and_si256(digit, _mm256_set1_epi8(52 - '0')));
+            shift = _mm256_or_si256(shift, _mm256_and_si256(is62, _mm256_set1_epi8(static_cast<char>(62 - c62))));
+            shift = _mm256_or_si256(shift, _mm256_and_si256(is63, _mm256_set1_epi8(static_cast<char>(63 - c63))));
+            const __m256i values = _mm256_add_epi8(c, shift);
+
+            const __m256i ab_cd = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+            const __m256i abcd = _mm256_madd_epi16(ab_cd, _mm256_set1_epi32(0x00011000));
+            const __m256i packed = _mm256_shuffle_epi8(abcd, _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1, 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(output), _mm256_permutevar8x32_epi32(packed, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7)));
+        }
+        invalid |= _mm256_movemask_epi8(all_valid) != -1;
+        return i;
+    }
+#endif
+
+    struct base64_kernels
+    {
+        base64_backend backend;
+        encode_kernel encode;
+        decode_kernel decode;
+    };
+    static constexpr base64_kernels portable_kernels{base64_backend::portable, encode_portable, decode_portable};
+#ifdef UTILS_X86
+    static constexpr base64_kernels ssse3_kernels{base64_backend::ssse3, encode_ssse3, decode_ssse3};
+    static constexpr base64_kernels avx2_kernels{base64_backend::avx2, encode_avx2, decode_avx2};
+#endif
+
+    static const base64_kernels *get_kernels(base64_backend backend) noexcept
+    {
+        switch (backend)
+        {
+        case base64_backend::portable:
+            return &portable_kernels;
+#ifdef UTILS_X86
+        case base64_backend::ssse3:
+            return get_cpu_features().ssse3 ? &ssse3_kernels : nullptr;
+        case base64_backend::avx2:
+            return get_cpu_features().avx2 ? &avx2_kernels : nullptr;
+#endif
+        default:
+            return nullptr;
+        }
+    }
+
+    static std::atomic<const base64_kernels *> &current_kernels() noexcept
+    {
+        static std::atomic<const base64_kernels *> kernels{[]()
+                                                           {
+                                                               for (auto backend : {base64_backend::avx2, base64_backend::ssse3})
+                                                                   if (auto k = get_kernels(backend))
+                                                                       return k;
+                                                               return get_kernels(base64_backend::portable);
+                                                           }()};
+        return kernels;
+    }
+
+    base64_backend get_base64_backend() noexcept { return current_kernels().load(std::memory_order_relaxed)->backend; }
+
+    bool set_base64_backend(base64_backend backend) noexcept
+    {
+        const auto kernels = get_kernels(backend);
+        if (!kernels)
+            return false;
+        current_kernels().store(kernels, std::memory_order_relaxed);
+        return true;
+    }
+
+    size_t base64_encode(const unsigned char *input, size_t len, char *output, base64_alphabet alphabet) noexcept
+    {
+        const char *chars = alphabet == base64_alphabet::standard ? standard_chars : url_chars;
+        char *out = output;
+        const size_t consumed = current_kernels().load(std::memory_order_relaxed)->encode(input, len, out, chars);
+        out += consumed / 3 * 4;
+
+        size_t i = consumed;
+        for (; i + 3 <= len; i += 3, out += 4)
+        {
+            const unsigned int group = (input[i] << 16) | (input[i + 1] << 8) | input[i + 2];
+            out[0] = chars[group >> 18];
+            out[1] = chars[(group >> 12) & 0x3F];
+            out[2] = chars[(group >> 6) & 0x3F];
+            out[3] = chars[group & 0x3F];
+        }
+        if (const size_t rem = len - i)
+        {
+            const unsigned int group = (input[i] << 16) | (rem == 2 ? input[i + 1] << 8 : 0);
+            *out++ = chars[group >> 18];
+            *out++ = chars[(group >> 12) & 0x3F];
+            if (rem == 2)
+                *out++ = chars[(group >> 6) & 0x3F];
+            if (alphabet == base64_alphabet::standard)
+                for (size_t p = rem; p < 3; ++p)
+                    *out++ = '=';
+        }
+        return static_cast<size_t>(out - output);
+    }
+
+    size_t base64_decode(const char *input, size_t len, unsigned char *output, base64_alphabet alphabet) noexcept
+    {
+        if (len && len % 4 == 0 && input[len - 1] == '=') // we strip the padding..
+            len -= input[len - 2] == '=' ? 2 : 1;
+        if (len % 4 == 1)
+            return base64_invalid;
+
+        const char *chars = alphabet == base64_alphabet::standard ? standard_chars : url_chars;
+        const unsigned char *table = alphabet == base64_alphabet::standard ? standard_table.values : url_table.values;
+        bool invalid = false;
+        unsigned char *out = output;
+        const size_t consumed = current_kernels().load(std::memory_order_relaxed)->decode(input, len, out, chars, invalid);
+        out += consumed / 4 * 3;
+
+        unsigned char bad = 0; // the OR of all the decoded values, whose upper bits are set by invalid characters..
+        size_t i = consumed;
+        for (; i + 4 <= len; i += 4, out += 3)
+        {
+            const unsigned char a = table[static_cast<unsigned char>(input[i])], b = table[static_cast<unsigned char>(input[i + 1])], c = table[static_cast<unsigned char>(input[i + 2])], d = table[static_cast<unsigned char>(input[i + 3])];
+            bad |= a | b | c | d;
+            out[0] = static_cast<unsigned char>((a << 2) | (b >> 4));
+            out[1] = static_cast<unsigned char>((b << 4) | (c >> 2));
+            out[2] = static_cast<unsigned char>((c << 6) | d);
+        }
+        if (const size_t rem = len - i)
+        {
+            const unsigned char a = table[static_cast<unsigned char>(input[i])], b = table[static_cast<unsigned char>(input[i + 1])], c = rem == 3 ? table[static_cast<unsigned char>(input[i + 2])] : 0;
+            bad |= a | b | c;
+            *out++ = static_cast<unsigned char>((a << 2) | (b >> 4));
+            if (rem == 3)
+                *out++ = static_cast<unsigned char>((b << 4) | (c >> 2));
+        }
+        if (invalid || (bad & 0xC0))
+            return base64_invalid;
+        return static_cast<size_t>(out - output);
+    }
+
+    base64_step base64_encoder::update(const unsigned char *input, size_t len, char *output, size_t capacity) noexcept
+    {
+        base64_step step{0, 0};
+        if (n_pending)
+        { // we complete the carried over group..
+            const size_t take = std::min(3 - n_pending, len);
+            if (n_pending + take == 3 && capacity < 4)
+                return step;
+            memcpy(pending + n_pending, input, take);
+            n_pending += take;
+            step.consumed = take;
+            if (n_pending < 3)
+                return step;
+            step.written = base64_encode(pending, 3, output, alphabet);
+            n_pending = 0;
+        }
+        // we encode as many whole groups as fit in the output..
+        const size_t groups = std::min((len - step.consumed) / 3, (capacity - step.written) / 4);
+        step.written += base64_encode(input + step.consumed, groups * 3, output + step.written, alphabet);
+        step.consumed += groups * 3;
+        if (len - step.consumed < 3)
+        { // we carry over the trailing bytes..
+            n_pending = len - step.consumed;
+            memcpy(pending, input + step.consumed, n_pending);
+            step.consumed = len;
+        }
+        return step;
+    }
+
+    size_t base64_encoder::finish(char *output) noexcept
+    {
+        const size_t written = base64_encode(pending, n_pending, output, alphabet);
+        n_pending = 0;
+        return written;
+    }
+
+    void base64_decoder::decode_groups(const char *input, size_t n_groups, unsigned char *output) noexcept
+    { // the groups are not the final ones, so they cannot be padded..
+        if (n_groups && (input[n_groups * 4 - 1] == '=' || base64_decode(input, n_groups * 4, output, alphabet) == base64_invalid))
+            invalid = true;
+    }
+
+    base64_step base64_decoder::update(const char *input, size_t len, unsigned char *output, size_t capacity) noexcept
+    {
+        if (invalid)
+            return {len, 0};
+        base64_step step{0, 0};
+        if (n_pending)
+        { // we complete the held back group..
+            const size_t take = std::min(4 - n_pending, len);
+            memcpy(pending + n_pending, input, take);
+            n_pending += take;
+            step.consumed = take;
+            if (n_pending < 4 || step.consumed == len || capacity < 3) // the group might still be the final one..
+                return step;
+            decode_groups(pending, 1, output);
+            step.written = 3;
+            n_pending = 0;
+        }
+        // we decode as many whole groups as fit in the output, holding back the last (up to four) characters..
+        const size_t left = len - step.consumed;
+        const size_t groups = std::min(left ? (left - 1) / 4 : 0, (capacity - step.written) / 3);
+        decode_groups(input + step.consumed, groups, output + step.written);
+        step.consumed += groups * 4;
+        step.written += groups * 3;
+        if (len - step.consumed <= 4)
+        {
+            n_pending = len - step.consumed;
+            memcpy(pending, input + step.consumed, n_pending);
+            step.consumed = len;
+        }
+        if (invalid)
+            return {len, 0};
+        return step;
+    }
+
+    size_t base64_decoder::finish(unsigned char *output) noexcept
+    {
+        const size_t written = invalid ? base64_invalid : base64_decode(pending, n_pending, output, alphabet);
+        n_pending = 0;
+        invalid = false;
+        return written;
+    }
+
+    static constexpr size_t stream_chunk = 12 * 1024; // a multiple of both 3 and 4..
+
+    void base64_encode(std::istream &in, std::ostream &out, base64_alphabet alphabet)
+    {
+        base64_encoder encoder(alphabet);
+        unsigned char input[stream_chunk];
+        char output[stream_chunk / 3 * 4 + base64_encoder::max_finish_size];
+        while (in)
+        {
+            in.read(reinterpret_cast<char *>(input), stream_chunk);
+            const auto step = encoder.update(input, static_cast<size_t>(in.gcount()), output, sizeof(output));
+            out.write(output, static_cast<std::streamsize>(step.written));
+        }
+        out.write(output, static_cast<std::streamsize>(encoder.finish(output)));
+    }
+
+    bool base64_decode(std::istream &in, std::ostream &out, base64_alphabet alphabet)
+    {
+        base64_decoder decoder(alphabet);
+        char input[stream_chunk];
+        unsigned char output[stream_chunk / 4 * 3 + base64_decoder::max_finish_size];
+        while (in && !decoder.failed())
+        {
+            in.read(input, stream_chunk);
+            const auto step = decoder.update(input, static_cast<size_t>(in.gcount()), output, sizeof(output));
+            out.write(reinterpret_cast<const char *>(output), static_cast<std::streamsize>(step.written));
+        }
+        const size_t written = decoder.finish(output);
+        if (written == base64_invalid)
+            return false;
+        out.write(reinterpret_cast<const char *>(output), static_cast<std::streamsize>(written));
+        return true;
+    }
+} // namespace utils
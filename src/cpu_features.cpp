@@ -0,0 +1,76 @@
+#include "cpu_features.hpp"
+
+#ifdef UTILS_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace utils
+{
+#ifdef UTILS_X86
+    static void cpuid(unsigned int leaf, unsigned int sub_leaf, unsigned int regs[4]) noexcept
+    {
+#ifdef _MSC_VER
+        int r[4];
+        __cpuidex(r, static_cast<int>(leaf), static_cast<int>(sub_leaf));
+        for (int i = 0; i < 4; ++i)
+            regs[i] = static_cast<unsigned int>(r[i]);
+#else
+        __cpuid_count(leaf, sub_leaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+    }
+
+    static unsigned long long xgetbv() noexcept
+    {
+#ifdef _MSC_VER
+        return _xgetbv(0);
+#else
+        unsigned int eax, edx;
+        __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+        return (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+    }
+#endif
+
+    static cpu_features detect_cpu_features() noexcept
+    {
+        cpu_features f;
+#ifdef UTILS_X86
+        unsigned int regs[4];
+        cpuid(0, 0, regs);
+        const unsigned int max_leaf = regs[0];
+        if (max_leaf < 1)
+            return f;
+
+        cpuid(1, 0, regs);
+        f.ssse3 = regs[2] & (1u << 9);
+        f.sse41 = regs[2] & (1u << 19);
+        const bool osxsave = regs[2] & (1u << 27);
+        const bool avx = regs[2] & (1u << 28);
+
+        // the operating system must save the AVX (and AVX-512) registers on context switches..
+        const unsigned long long xcr0 = osxsave ? xgetbv() : 0;
+        const bool avx_os = avx && (xcr0 & 0x6) == 0x6;
+        const bool avx512_os = avx_os && (xcr0 & 0xE0) == 0xE0;
+
+        if (max_leaf >= 7)
+        {
+            cpuid(7, 0, regs);
+            f.avx2 = avx_os && (regs[1] & (1u << 5));
+            f.avx512f = avx512_os && (regs[1] & (1u << 16));
+            f.avx512bw = avx512_os && (regs[1] & (1u << 30));
+            f.sha = regs[1] & (1u << 29);
+        }
+#endif
+        return f;
+    }
+
+    const cpu_features &get_cpu_features() noexcept
+    {
+        static const cpu_features features = detect_cpu_features();
+        return features;
+    }
+} // namespace utils
@@ -2,59 +2,357 @@
 #include <openssl/evp.h>
 #include <openssl/pem.h>
 #include <openssl/rand.h>
-#include <sstream>
-#include <iomanip>
+#include <array>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
 
 namespace utils
 {
-    std::string encode_password(std::string_view password, std::string_view salt)
+    /**
+     * Maps each byte to its two hexadecimal digits.
+     */
+    struct hex_table
+    {
+        constexpr hex_table() : pairs{}
+        {
+            constexpr char digits[] = "0123456789abcdef";
+            for (size_t i = 0; i < 256; ++i)
+            {
+                pairs[i * 2] = digits[i >> 4];
+                pairs[i * 2 + 1] = digits[i & 0xF];
+            }
+        }
+
+        char pairs[512];
+    };
+    static constexpr hex_table hex_pairs;
+
+    static std::string to_hex(const unsigned char *data, size_t len)
+    {
+        std::string hex(len * 2, '\0');
+        for (size_t i = 0; i < len; ++i)
+            memcpy(&hex[i * 2], hex_pairs.pairs + data[i] * 2, 2);
+        return hex;
+    }
+
+    std::string encode_password(std::string_view password, std::string_view salt, int iterations)
     {
-        int iterations = 10000;
         unsigned char hash[32];
         if (PKCS5_PBKDF2_HMAC(password.data(), password.size(), reinterpret_cast<const unsigned char *>(salt.data()), salt.size(), iterations, EVP_sha256(), sizeof(hash), hash) == 0)
             throw std::runtime_error("PKCS5_PBKDF2_HMAC failed");
-
-        std::ostringstream hash_stream;
-        for (unsigned char c : hash)
-            hash_stream << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(c);
-        return hash_stream.str();
+        return to_hex(hash, sizeof(hash));
     }
 
-    std::pair<std::string, std::string> encode_password(std::string_view password)
+    std::pair<std::string, std::string> encode_password(std::string_view password, int iterations)
     {
         unsigned char salt[16];
-        RAND_bytes(salt, sizeof(salt));
-        std::ostringstream salt_stream;
-        for (unsigned char c : salt)
-            salt_stream << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(c);
-        return {salt_stream.str(), encode_password(password, salt_stream.str())};
+        if (RAND_bytes(salt, sizeof(salt)) != 1)
+            throw std::runtime_error("RAND_bytes failed");
+        std::string salt_hex = to_hex(salt, sizeof(salt));
+        std::string encoded = encode_password(password, salt_hex, iterations);
+        return {std::move(salt_hex), std::move(encoded)};
     }
 
-    std::string sign_rs256(std::string_view data, std::string_view private_key_pem)
+    password_hasher::password_hasher(size_t threads, int iterations, size_t max_pending) : iterations(iterations), max_pending(max_pending ? max_pending : 1)
     {
-        BIO *bio = BIO_new_mem_buf(private_key_pem.data(), private_key_pem.size());
-        EVP_PKEY *pkey = PEM_read_bio_PrivateKey(bio, nullptr, nullptr, nullptr);
-        BIO_free(bio);
+        if (threads == 0)
+            threads = 1;
+        workers.reserve(threads);
+        for (size_t i = 0; i < threads; ++i)
+            workers.emplace_back(&password_hasher::run, this);
+    }
+
+    password_hasher::~password_hasher()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            running = false;
+        }
+        cv.notify_all();
+        for (auto &worker : workers)
+            worker.join();
+    }
+
+    std::future<std::string> password_hasher::encode(std::string password, std::string salt)
+    {
+        auto promise = std::make_shared<std::promise<std::string>>();
+        auto future = promise->get_future();
+        submit([this, promise, password = std::move(password), salt = std::move(salt)]()
+               {
+                   try
+                   {
+                       promise->set_value(encode_password(password, salt, iterations));
+                   }
+                   catch (...)
+                   {
+                       promise->set_exception(std::current_exception());
+                   } });
+        return future;
+    }
+
+    std::future<std::pair<std::string, std::string>> password_hasher::encode(std::string password)
+    {
+        auto promise = std::make_shared<std::promise<std::pair<std::string, std::string>>>();
+        auto future = promise->get_future();
+        submit([this, promise, password = std::move(password)]()
+               {
+                   try
+                   {
+                       promise->set_value(encode_password(password, iterations));
+                   }
+                   catch (...)
+                   {
+                       promise->set_exception(std::current_exception());
+                   } });
+        return future;
+    }
+
+    std::vector<std::future<std::string>> password_hasher::encode(std::vector<std::pair<std::string, std::string>> passwords)
+    {
+        std::vector<std::future<std::string>> futures;
+        futures.reserve(passwords.size());
+        for (auto &[password, salt] : passwords)
+            futures.push_back(encode(std::move(password), std::move(salt)));
+        return futures;
+    }
 
+    void password_hasher::encode(std::string password, std::string salt, std::function<void(std::string)> callback)
+    {
+        submit([this, password = std::move(password), salt = std::move(salt), callback = std::move(callback)]()
+               {
+                   std::string encoded;
+                   try
+                   {
+                       encoded = encode_password(password, salt, iterations);
+                   }
+                   catch (...)
+                   { // any failure yields an empty string..
+                   }
+                   try
+                   {
+                       callback(std::move(encoded));
+                   }
+                   catch (...)
+                   { // the exceptions of the callback have nowhere to go, and must not terminate the worker..
+                   } });
+    }
+
+    void password_hasher::submit(std::function<void()> task)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            room_cv.wait(lock, [this]()
+                         { return tasks.size() < max_pending; });
+            tasks.push_back(std::move(task));
+        }
+        cv.notify_one();
+    }
+
+    void password_hasher::run()
+    {
+        while (true)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                cv.wait(lock, [this]()
+                        { return !tasks.empty() || !running; });
+                if (tasks.empty()) // stopped, with no queued requests left..
+                    return;
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            room_cv.notify_one();
+            task();
+        }
+    }
+
+    /**
+     * The digest context of the calling thread, reused by all its signatures.
+     */
+    struct thread_md_ctx
+    {
         EVP_MD_CTX *ctx = EVP_MD_CTX_new();
-        EVP_PKEY_CTX *pkey_ctx = nullptr;
-        std::string signature;
-        size_t sig_len = 0;
+        ~thread_md_ctx() { EVP_MD_CTX_free(ctx); }
+    };
+
+    static EVP_MD_CTX *get_thread_md_ctx()
+    {
+        thread_local thread_md_ctx t;
+        if (!t.ctx)
+            throw std::runtime_error("EVP_MD_CTX_new failed");
+        return t.ctx;
+    }
+
+    rs256_signer::rs256_signer(std::string_view private_key_pem) : pkey(nullptr), init_ctx(nullptr), sig_len(0)
+    {
+        BIO *bio = BIO_new_mem_buf(private_key_pem.data(), static_cast<int>(private_key_pem.size()));
+        pkey = PEM_read_bio_PrivateKey(bio, nullptr, nullptr, nullptr);
+        BIO_free(bio);
 
-        if (EVP_DigestSignInit(ctx, &pkey_ctx, EVP_sha256(), nullptr, pkey) == 1 && EVP_DigestSignUpdate(ctx, data.data(), data.size()) == 1 && EVP_DigestSignFinal(ctx, nullptr, &sig_len) == 1)
+        if (!pkey)
+            throw std::runtime_error("Failed to read private key");
+
+        init_ctx = EVP_MD_CTX_new();
+        if (!init_ctx || EVP_DigestSignInit(init_ctx, nullptr, EVP_sha256(), nullptr, pkey) != 1)
         {
-            signature.resize(sig_len);
-            if (EVP_DigestSignFinal(ctx, (unsigned char *)signature.data(), &sig_len) == 1)
-                signature.resize(sig_len);
-            else
-                signature.clear();
+            EVP_MD_CTX_free(init_ctx);
+            EVP_PKEY_free(pkey);
+            throw std::runtime_error("EVP_DigestSignInit failed");
         }
+        sig_len = static_cast<size_t>(EVP_PKEY_size(pkey));
+    }
 
-        EVP_MD_CTX_free(ctx);
+    rs256_signer::~rs256_signer()
+    {
+        EVP_MD_CTX_free(init_ctx);
         EVP_PKEY_free(pkey);
+    }
+
+    std::string rs256_signer::sign(std::string_view data) const
+    {
+        std::string signature;
+        sign(data, signature, get_thread_md_ctx());
         return signature; // binary signature, base64url-encode for JWT
     }
 
+    std::vector<std::string> rs256_signer::sign(const std::vector<std::string_view> &data) const
+    {
+        EVP_MD_CTX *ctx = get_thread_md_ctx();
+        std::vector<std::string> signatures(data.size());
+        for (size_t i = 0; i < data.size(); ++i)
+            sign(data[i], signatures[i], ctx);
+        return signatures;
+    }
+
+    void rs256_signer::sign(std::string_view data, std::string &signature, EVP_MD_CTX *ctx) const
+    {
+        if (EVP_MD_CTX_copy_ex(ctx, init_ctx) != 1 || EVP_DigestSignUpdate(ctx, data.data(), data.size()) != 1)
+            throw std::runtime_error("EVP_DigestSignUpdate failed");
+
+        size_t len = sig_len;
+        signature.resize(len);
+        if (EVP_DigestSignFinal(ctx, reinterpret_cast<unsigned char *>(signature.data()), &len) != 1)
+            throw std::runtime_error("EVP_DigestSignFinal failed");
+        signature.resize(len);
+    }
+
+    std::string sign_rs256(std::string_view data, std::string_view private_key_pem)
+    {
+        // only a digest of the cached key is kept, so that no copy of the private key outlives the call..
+        thread_local std::array<unsigned char, 32> cached_digest{};
+        thread_local std::unique_ptr<rs256_signer> cached_signer;
+        try
+        {
+            std::array<unsigned char, 32> digest;
+            if (EVP_Digest(private_key_pem.data(), private_key_pem.size(), digest.data(), nullptr, EVP_sha256(), nullptr) != 1)
+                throw std::runtime_error("Failed to hash the private key");
+            if (!cached_signer || cached_digest != digest)
+            {
+                cached_signer.reset();
+                cached_signer = std::make_unique<rs256_signer>(private_key_pem);
+                cached_digest = digest;
+            }
+            return cached_signer->sign(data); // binary signature, base64url-encode for JWT
+        }
+        catch (const std::runtime_error &)
+        { // failures yield an empty signature, as they always did..
+            return {};
+        }
+    }
+
+    /**
+     * A parsed public key, together with a verification context initialized with it.
+     */
+    struct rs256_verifier::key
+    {
+        key(EVP_PKEY *pkey, EVP_MD_CTX *init_ctx) noexcept : pkey(pkey), init_ctx(init_ctx) {}
+        ~key()
+        {
+            EVP_MD_CTX_free(init_ctx);
+            EVP_PKEY_free(pkey);
+        }
+
+        key(const key &) = delete;
+        key &operator=(const key &) = delete;
+
+        /**
+         * Verifies a signature through the given digest context.
+         */
+        [[nodiscard]] bool verify(std::string_view data, std::string_view signature, EVP_MD_CTX *ctx) const noexcept { return EVP_MD_CTX_copy_ex(ctx, init_ctx) == 1 && EVP_DigestVerifyUpdate(ctx, data.data(), data.size()) == 1 && EVP_DigestVerifyFinal(ctx, reinterpret_cast<const unsigned char *>(signature.data()), signature.size()) == 1; }
+
+        EVP_PKEY *const pkey;
+        EVP_MD_CTX *const init_ctx;
+    };
+
+    void rs256_verifier::add_key(std::string_view key_id, std::string_view public_key_pem)
+    {
+        BIO *bio = BIO_new_mem_buf(public_key_pem.data(), static_cast<int>(public_key_pem.size()));
+        EVP_PKEY *pkey = PEM_read_bio_PUBKEY(bio, nullptr, nullptr, nullptr);
+        BIO_free(bio);
+
+        if (!pkey)
+            throw std::runtime_error("Failed to read public key");
+
+        EVP_MD_CTX *init_ctx = EVP_MD_CTX_new();
+        if (!init_ctx || EVP_DigestVerifyInit(init_ctx, nullptr, EVP_sha256(), nullptr, pkey) != 1)
+        {
+            EVP_MD_CTX_free(init_ctx);
+            EVP_PKEY_free(pkey);
+            throw std::runtime_error("EVP_DigestVerifyInit failed");
+        }
+
+        auto k = std::make_shared<const key>(pkey, init_ctx);
+        std::unique_lock<std::shared_mutex> lock(mtx);
+        keys.insert_or_assign(std::string(key_id), std::move(k));
+    }
+
+    bool rs256_verifier::remove_key(std::string_view key_id)
+    {
+        std::unique_lock<std::shared_mutex> lock(mtx);
+        if (auto it = keys.find(key_id); it != keys.end())
+        {
+            keys.erase(it);
+            return true;
+        }
+        return false;
+    }
+
+    bool rs256_verifier::has_key(std::string_view key_id) const
+    {
+        std::shared_lock<std::shared_mutex> lock(mtx);
+        return keys.find(key_id) != keys.end();
+    }
+
+    std::shared_ptr<const rs256_verifier::key> rs256_verifier::find(std::string_view key_id) const
+    {
+        std::shared_lock<std::shared_mutex> lock(mtx);
+        if (auto it = keys.find(key_id); it != keys.end())
+            return it->second;
+        return nullptr;
+    }
+
+    bool rs256_verifier::verify(std::string_view key_id, std::string_view data, std::string_view signature) const
+    {
+        const auto k = find(key_id);
+        return k && k->verify(data, signature, get_thread_md_ctx());
+    }
+
+    std::vector<bool> rs256_verifier::verify(const std::vector<rs256_token> &tokens) const
+    {
+        EVP_MD_CTX *ctx = get_thread_md_ctx();
+        std::vector<bool> valid(tokens.size(), false);
+        std::shared_ptr<const key> k;
+        for (size_t i = 0; i < tokens.size(); ++i)
+        {
+            if (i == 0 || tokens[i].key_id != tokens[i - 1].key_id) // tokens usually share their keys, so we look up only on changes..
+                k = find(tokens[i].key_id);
+            valid[i] = k && k->verify(tokens[i].data, tokens[i].signature, ctx);
+        }
+        return valid;
+    }
+
     std::string extract_public_key(std::string_view private_key_pem)
     {
         BIO *bio = BIO_new_mem_buf(private_key_pem.data(), private_key_pem.size());
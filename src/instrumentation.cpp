@@ -0,0 +1,336 @@
+#include "instrumentation.hpp"
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+#include <vector>
+
+namespace utils
+{
+    static constexpr std::size_t max_counters = 256;   // the maximum number of distinct counters..
+    static constexpr std::size_t max_histograms = 128; // the maximum number of distinct histograms..
+
+    /**
+     * @brief The names of the registered counters or histograms.
+     */
+    struct metric_names final
+    {
+        std::mutex mtx;
+        std::vector<std::string> names;
+        std::unordered_map<std::string, std::uint32_t> ids;
+
+        std::uint32_t add(const char *name, std::size_t capacity) noexcept
+        {
+            try
+            {
+                std::lock_guard<std::mutex> _(mtx);
+                if (const auto it = ids.find(name); it != ids.end())
+                    return it->second;
+                if (names.size() == capacity)
+                    return static_cast<std::uint32_t>(capacity); // out of room, so the metric is ignored..
+                names.emplace_back(name);
+                try
+                {
+                    return ids[name] = static_cast<std::uint32_t>(names.size() - 1);
+                }
+                catch (...)
+                {
+                    names.pop_back();
+                    throw;
+                }
+            }
+            catch (...)
+            { // the instrumentation never fails the instrumented code, so the metric is ignored..
+                return static_cast<std::uint32_t>(capacity);
+            }
+        }
+        std::vector<std::string> get()
+        {
+            std::lock_guard<std::mutex> _(mtx);
+            return names;
+        }
+    };
+
+    static metric_names &counter_names()
+    {
+        static metric_names names;
+        return names;
+    }
+    static metric_names &histogram_names()
+    {
+        static metric_names names;
+        return names;
+    }
+
+    std::uint32_t register_counter(const char *name) noexcept { return counter_names().add(name, max_counters); }
+    std::uint32_t register_histogram(const char *name) noexcept { return histogram_names().add(name, max_histograms); }
+
+    /**
+     * @brief A histogram of a single thread.
+     *
+     * Only the owning thread writes the histogram, so that relaxed loads and stores suffice, while snapshots read it concurrently.
+     */
+    struct thread_histogram final
+    {
+        std::atomic<std::uint64_t> count{0}, sum{0}, min{~std::uint64_t(0)}, max{0};
+        std::array<std::atomic<std::uint64_t>, 65> buckets{};
+
+        void record(std::uint64_t value) noexcept
+        {
+            bump(count, 1);
+            bump(sum, value);
+            if (value < min.load(std::memory_order_relaxed))
+                min.store(value, std::memory_order_relaxed);
+            if (value > max.load(std::memory_order_relaxed))
+                max.store(value, std::memory_order_relaxed);
+            std::size_t bits = 0;
+            for (auto v = value; v; v >>= 1)
+                ++bits;
+            bump(buckets[bits], 1);
+        }
+
+        void reset() noexcept
+        {
+            count.store(0, std::memory_order_relaxed);
+            sum.store(0, std::memory_order_relaxed);
+            min.store(~std::uint64_t(0), std::memory_order_relaxed);
+            max.store(0, std::memory_order_relaxed);
+            for (auto &b : buckets)
+                b.store(0, std::memory_order_relaxed);
+        }
+
+        static void bump(std::atomic<std::uint64_t> &a, std::uint64_t n) noexcept { a.store(a.load(std::memory_order_relaxed) + n, std::memory_order_relaxed); }
+    };
+
+    /**
+     * @brief A trace event, as recorded by a scoped timer.
+     */
+    struct trace_event final
+    {
+        std::uint32_t histogram; // the identifier of the histogram of the timer..
+        std::int64_t start_ns;   // the start time, relative to the origin of the trace..
+        std::int64_t duration_ns;
+    };
+
+    /**
+     * @brief The metrics of a single thread.
+     */
+    struct thread_metrics final
+    {
+        std::size_t tid; // the sequential identifier of the thread..
+        std::array<std::atomic<std::uint64_t>, max_counters> counters{};
+        std::array<std::atomic<thread_histogram *>, max_histograms> histograms{}; // allocated on the first use..
+        std::mutex events_mtx;                                                    // guards the events against the exports..
+        std::vector<trace_event> events;
+
+        ~thread_metrics()
+        {
+            for (auto &h : histograms)
+                delete h.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Returns the histogram with the given identifier, allocating it on the first use, or `nullptr` if the allocation fails.
+         */
+        thread_histogram *histogram(std::uint32_t id) noexcept
+        {
+            auto h = histograms[id].load(std::memory_order_relaxed);
+            if (!h && (h = new (std::nothrow) thread_histogram()))
+                histograms[id].store(h, std::memory_order_release);
+            return h;
+        }
+    };
+
+    /**
+     * @brief The metrics of all the threads, kept after the threads terminate so that their contribution is not lost.
+     */
+    struct metrics_registry final
+    {
+        std::mutex mtx;
+        std::vector<std::shared_ptr<thread_metrics>> threads;
+        std::atomic<bool> tracing{false};
+        const std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+
+        std::vector<std::shared_ptr<thread_metrics>> get()
+        {
+            std::lock_guard<std::mutex> _(mtx);
+            return threads;
+        }
+    };
+
+    static metrics_registry &registry()
+    {
+        static metrics_registry r;
+        return r;
+    }
+
+    /**
+     * @brief Returns the metrics of the calling thread, registering them on the first use, or `nullptr` if the registration fails.
+     */
+    static thread_metrics *get_thread_metrics() noexcept
+    {
+        thread_local std::shared_ptr<thread_metrics> tm;
+        if (!tm)
+            try
+            {
+                auto &r = registry();
+                auto m = std::make_shared<thread_metrics>();
+                std::lock_guard<std::mutex> _(r.mtx);
+                m->tid = r.threads.size() + 1;
+                r.threads.push_back(m);
+                tm = std::move(m);
+            }
+            catch (...)
+            { // the values are dropped, and the registration is retried on the next use..
+                return nullptr;
+            }
+        return tm.get();
+    }
+
+    void count(std::uint32_t counter, std::uint64_t n) noexcept
+    {
+        if (counter < max_counters)
+            if (auto tm = get_thread_metrics())
+                thread_histogram::bump(tm->counters[counter], n);
+    }
+
+    void record(std::uint32_t histogram, std::uint64_t value) noexcept
+    {
+        if (histogram < max_histograms)
+            if (auto tm = get_thread_metrics())
+                if (auto h = tm->histogram(histogram))
+                    h->record(value);
+    }
+
+    scoped_timer::~scoped_timer()
+    {
+        if (histogram >= max_histograms)
+            return;
+        const auto end = std::chrono::steady_clock::now();
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+        auto tm = get_thread_metrics();
+        if (!tm)
+            return;
+        if (auto h = tm->histogram(histogram))
+            h->record(static_cast<std::uint64_t>(ns));
+        auto &r = registry();
+        if (r.tracing.load(std::memory_order_relaxed))
+            try
+            {
+                std::lock_guard<std::mutex> _(tm->events_mtx);
+                tm->events.push_back({histogram, std::chrono::duration_cast<std::chrono::nanoseconds>(start - r.origin).count(), ns});
+            }
+            catch (...)
+            { // the event is dropped..
+            }
+    }
+
+    metrics_snapshot get_metrics()
+    {
+        metrics_snapshot snapshot;
+        const auto c_names = counter_names().get();
+        const auto h_names = histogram_names().get();
+        for (const auto &name : c_names)
+            snapshot.counters[name] = 0;
+        for (const auto &tm : registry().get())
+        {
+            for (std::size_t i = 0; i < c_names.size(); ++i)
+                snapshot.counters[c_names[i]] += tm->counters[i].load(std::memory_order_relaxed);
+            for (std::size_t i = 0; i < h_names.size(); ++i)
+                if (const auto h = tm->histograms[i].load(std::memory_order_acquire))
+                {
+                    const auto c = h->count.load(std::memory_order_relaxed);
+                    if (!c)
+                        continue;
+                    auto &s = snapshot.histograms[h_names[i]];
+                    const auto c_min = h->min.load(std::memory_order_relaxed), c_max = h->max.load(std::memory_order_relaxed);
+                    s.min = s.count ? std::min(s.min, c_min) : c_min;
+                    s.max = std::max(s.max, c_max);
+                    s.count += c;
+                    s.sum += h->sum.load(std::memory_order_relaxed);
+                    for (std::size_t b = 0; b < s.buckets.size(); ++b)
+                        s.buckets[b] += h->buckets[b].load(std::memory_order_relaxed);
+                }
+        }
+        return snapshot;
+    }
+
+    void reset_metrics() noexcept
+    {
+        for (const auto &tm : registry().get())
+        {
+            for (auto &c : tm->counters)
+                c.store(0, std::memory_order_relaxed);
+            for (auto &h : tm->histograms)
+                if (const auto c_h = h.load(std::memory_order_acquire))
+                    c_h->reset();
+            std::lock_guard<std::mutex> _(tm->events_mtx);
+            tm->events.clear();
+        }
+    }
+
+    static void write_string(std::ostream &os, const std::string &str)
+    {
+        os << '"';
+        for (const char c : str)
+            if (c == '"' || c == '\\')
+                os << '\\' << c;
+            else if (static_cast<unsigned char>(c) >= 0x20)
+                os << c;
+        os << '"';
+    }
+
+    void write_metrics_json(std::ostream &os)
+    {
+        const auto snapshot = get_metrics();
+        os << "{\"counters\": {";
+        bool first = true;
+        for (const auto &[name, value] : snapshot.counters)
+        {
+            os << (first ? "" : ", ");
+            write_string(os, name);
+            os << ": " << value;
+            first = false;
+        }
+        os << "}, \"histograms\": {";
+        first = true;
+        for (const auto &[name, h] : snapshot.histograms)
+        {
+            os << (first ? "" : ", ");
+            write_string(os, name);
+            os << ": {\"count\": " << h.count << ", \"sum\": " << h.sum << ", \"min\": " << h.min << ", \"max\": " << h.max << ", \"mean\": " << h.mean() << ", \"buckets\": [";
+            std::size_t last = h.buckets.size();
+            while (last > 0 && !h.buckets[last - 1])
+                --last;
+            for (std::size_t b = 0; b < last; ++b)
+                os << (b ? ", " : "") << h.buckets[b];
+            os << "]}";
+            first = false;
+        }
+        os << "}}\n";
+    }
+
+    void start_tracing() noexcept { registry().tracing.store(true, std::memory_order_relaxed); }
+    void stop_tracing() noexcept { registry().tracing.store(false, std::memory_order_relaxed); }
+
+    void write_chrome_trace(std::ostream &os)
+    {
+        const auto h_names = histogram_names().get();
+        os << "{\"traceEvents\": [";
+        bool first = true;
+        for (const auto &tm : registry().get())
+        {
+            std::lock_guard<std::mutex> _(tm->events_mtx);
+            for (const auto &e : tm->events)
+            {
+                os << (first ? "\n" : ",\n") << "{\"name\": ";
+                write_string(os, e.histogram < h_names.size() ? h_names[e.histogram] : std::string("?"));
+                os << ", \"ph\": \"X\", \"pid\": 1, \"tid\": " << tm->tid << ", \"ts\": " << e.start_ns / 1e3 << ", \"dur\": " << e.duration_ns / 1e3 << '}';
+                first = false;
+            }
+        }
+        os << "\n], \"displayTimeUnit\": \"ns\"}\n";
+    }
+} // namespace utils
@@ -0,0 +1,541 @@
+#include "logging.hpp"
+#include <condition_variable>
+#include <algorithm>
+#include <chrono>
+#include <streambuf>
+#include <cstring>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <sstream>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+
+namespace utils
+{
+    /**
+     * @brief A single-producer single-consumer lock-free ring buffer of log records.
+     *
+     * Each record is stored as its length followed by its bytes, possibly wrapping around the end of the buffer.
+     */
+    class log_ring final
+    {
+    public:
+        static constexpr std::size_t capacity = 1 << 16; // the size of the buffer in bytes (a power of two)..
+
+        /**
+         * @brief Pushes a record into the ring, returning false if there is not enough room.
+         *
+         * Records larger than the buffer are truncated.
+         */
+        bool push(const char *data, std::size_t len) noexcept
+        {
+            len = std::min(len, capacity - sizeof(std::uint32_t));
+            const auto c_head = head.load(std::memory_order_relaxed);
+            if (capacity - (c_head - tail.load(std::memory_order_acquire)) < sizeof(std::uint32_t) + len)
+                return false;
+            const auto c_len = static_cast<std::uint32_t>(len);
+            write(c_head, reinterpret_cast<const char *>(&c_len), sizeof(c_len));
+            write(c_head + sizeof(c_len), data, len);
+            head.store(c_head + sizeof(c_len) + len, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * @brief Pops all the records of the ring, passing each of them to the given function.
+         */
+        template <typename F>
+        void drain(std::string &scratch, F f)
+        {
+            auto c_tail = tail.load(std::memory_order_relaxed);
+            const auto c_head = head.load(std::memory_order_acquire);
+            while (c_tail != c_head)
+            {
+                std::uint32_t len;
+                read(c_tail, reinterpret_cast<char *>(&len), sizeof(len));
+                scratch.resize(len);
+                read(c_tail + sizeof(len), scratch.data(), len);
+                f(scratch.data(), scratch.size());
+                c_tail += sizeof(len) + len;
+            }
+            tail.store(c_tail, std::memory_order_release);
+        }
+
+        [[nodiscard]] bool empty() const noexcept { return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire); }
+
+    private:
+        void write(std::size_t pos, const char *data, std::size_t len) noexcept
+        {
+            pos &= capacity - 1;
+            const auto first = std::min(len, capacity - pos);
+            std::memcpy(buffer.get() + pos, data, first);
+            std::memcpy(buffer.get(), data + first, len - first);
+        }
+        void read(std::size_t pos, char *data, std::size_t len) const noexcept
+        {
+            pos &= capacity - 1;
+            const auto first = std::min(len, capacity - pos);
+            std::memcpy(data, buffer.get() + pos, first);
+            std::memcpy(data + first, buffer.get(), len - first);
+        }
+
+    private:
+        std::unique_ptr<char[]> buffer{new char[capacity]};
+        alignas(64) std::atomic<std::size_t> head{0}; // written by the producer..
+        alignas(64) std::atomic<std::size_t> tail{0}; // written by the consumer..
+    };
+
+#ifdef LOGGING_BINARY
+    /**
+     * @brief A logging site.
+     */
+    struct log_site final
+    {
+        std::string file;
+        unsigned line = 0;
+        unsigned level = 0;
+    };
+
+    constexpr char site_frame = 0;   // a frame defining a logging site..
+    constexpr char record_frame = 1; // a frame containing a log record..
+
+    static std::mutex &sites_mtx()
+    {
+        static auto *mtx = new std::mutex(); // never destroyed, so that sites can be registered during the static destruction..
+        return *mtx;
+    }
+    static std::vector<log_site> &sites()
+    {
+        static auto *sts = new std::vector<log_site>();
+        return *sts;
+    }
+
+    std::uint32_t register_log_site(const char *file, unsigned line, unsigned level) noexcept
+    {
+        std::lock_guard<std::mutex> _(sites_mtx());
+        sites().push_back({file, line, level});
+        return static_cast<std::uint32_t>(sites().size() - 1);
+    }
+
+    static log_site get_log_site(std::uint32_t id)
+    {
+        std::lock_guard<std::mutex> _(sites_mtx());
+        return id < sites().size() ? sites()[id] : log_site();
+    }
+
+    template <typename V>
+    static void append(std::string &out, const V &value) { out.append(reinterpret_cast<const char *>(&value), sizeof(value)); }
+
+    template <typename V>
+    static bool extract(const char *data, std::size_t len, std::size_t &pos, V &value) noexcept
+    {
+        if (len - pos < sizeof(value))
+            return false;
+        std::memcpy(&value, data + pos, sizeof(value));
+        pos += sizeof(value);
+        return true;
+    }
+
+    static void write_site(std::string &out, std::uint32_t id, const log_site &site)
+    {
+        out.push_back(site_frame);
+        append(out, id);
+        append(out, static_cast<std::uint32_t>(site.line));
+        append(out, static_cast<std::uint32_t>(site.level));
+        append(out, static_cast<std::uint32_t>(site.file.size()));
+        out.append(site.file);
+    }
+
+    /**
+     * @brief Formats the arguments of a binary log record, appending the resulting line to `out`.
+     *
+     * @return bool True if the arguments were well-formed, false otherwise.
+     */
+    static bool format_record(std::string &out, const std::string &file, unsigned line, unsigned level, const char *args, std::size_t len)
+    {
+        static const char *colors[] = {COLOR_NORMAL, COLOR_BOLD_RED, COLOR_RED, COLOR_YELLOW, COLOR_NORMAL, COLOR_GREEN, COLOR_BLUE};
+        out += level < sizeof(colors) / sizeof(colors[0]) ? colors[level] : COLOR_NORMAL;
+        out += file + "(" + std::to_string(line) + "): ";
+        std::size_t pos = 0;
+        bool ok = true;
+        while (ok && pos < len)
+            switch (static_cast<log_arg>(args[pos++]))
+            {
+            case log_arg::boolean:
+            {
+                unsigned char v;
+                if ((ok = extract(args, len, pos, v)))
+                    out += v ? "1" : "0";
+                break;
+            }
+            case log_arg::character:
+            {
+                char v;
+                if ((ok = extract(args, len, pos, v)))
+                    out.push_back(v);
+                break;
+            }
+            case log_arg::int64:
+            {
+                std::int64_t v;
+                if ((ok = extract(args, len, pos, v)))
+                    out += std::to_string(v);
+                break;
+            }
+            case log_arg::uint64:
+            {
+                std::uint64_t v;
+                if ((ok = extract(args, len, pos, v)))
+                    out += std::to_string(v);
+                break;
+            }
+            case log_arg::float64:
+            {
+                double v;
+                if ((ok = extract(args, len, pos, v)))
+                {
+                    std::ostringstream os;
+                    os << v;
+                    out += os.str();
+                }
+                break;
+            }
+            case log_arg::string:
+            {
+                std::uint32_t str_len;
+                if ((ok = extract(args, len, pos, str_len) && len - pos >= str_len))
+                {
+                    out.append(args + pos, str_len);
+                    pos += str_len;
+                }
+                break;
+            }
+            default:
+                ok = false;
+            }
+        out += COLOR_NORMAL;
+        out.push_back('\n');
+        return ok;
+    }
+
+    bool decode_binary_log(std::istream &in, std::ostream &out)
+    {
+        std::unordered_map<std::uint32_t, log_site> c_sites;
+        std::string buf, line;
+        char kind;
+        while (in.get(kind))
+        {
+            std::uint32_t header[4];
+            const std::size_t header_size = kind == site_frame ? 4 : 1;
+            if (kind != site_frame && kind != record_frame)
+                return false;
+            if (!in.read(reinterpret_cast<char *>(header), header_size * sizeof(std::uint32_t)))
+                return false;
+            buf.resize(header[header_size - 1]);
+            if (!in.read(buf.data(), buf.size()))
+                return false;
+            if (kind == site_frame)
+            {
+                c_sites[header[0]] = {buf, header[1], header[2]};
+                continue;
+            }
+
+            std::uint32_t id;
+            if (buf.size() < sizeof(id))
+                return false;
+            std::memcpy(&id, buf.data(), sizeof(id));
+            const auto site = c_sites.find(id);
+            if (site == c_sites.end())
+                return false;
+            line.clear();
+            const bool ok = format_record(line, site->second.file, site->second.line, site->second.level, buf.data() + sizeof(id), buf.size() - sizeof(id));
+            out << line;
+            if (!ok)
+                return false;
+        }
+        return true;
+    }
+#endif
+
+    /**
+     * @brief The background thread draining the ring buffers of all the logging threads.
+     */
+    class async_logger final
+    {
+    public:
+        async_logger() : th([this]()
+                            { run(); }) { destroyed.store(false, std::memory_order_release); }
+        ~async_logger()
+        {
+            destroyed.store(true, std::memory_order_release);
+            {
+                std::lock_guard<std::mutex> _(mtx);
+                running = false;
+            }
+            cv.notify_one();
+            th.join();
+        }
+
+        static async_logger &get_instance()
+        {
+            static async_logger logger;
+            return logger;
+        }
+        [[nodiscard]] static bool is_destroyed() noexcept { return destroyed.load(std::memory_order_acquire); }
+
+        std::shared_ptr<log_ring> new_ring()
+        {
+            auto ring = std::make_shared<log_ring>();
+            std::lock_guard<std::mutex> _(mtx);
+            rings.push_back(ring);
+            return ring;
+        }
+
+        void push(log_ring &ring, const std::string &record) noexcept
+        {
+            while (!ring.push(record.data(), record.size()))
+                if (policy.load(std::memory_order_relaxed) == log_overflow_policy::drop)
+                {
+                    dropped.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                else
+                { // we wake up the background thread and wait for it to make room..
+                    cv.notify_one();
+                    std::this_thread::yield();
+                }
+            if (sleeping.load(std::memory_order_relaxed))
+                cv.notify_one();
+        }
+
+        void flush() noexcept
+        {
+            std::unique_lock<std::mutex> lock(mtx);
+            const auto ticket = ++flush_requests;
+            cv.notify_one();
+            flushed_cv.wait(lock, [this, ticket]()
+                            { return flushed >= ticket || !running; });
+        }
+
+        void set_sink(std::ostream &s, bool binary = false) noexcept
+        {
+            std::lock_guard<std::mutex> _(sink_mtx);
+            sink = &s;
+            raw = binary;
+            emitted_sites.clear();
+        }
+
+    public:
+        std::atomic<log_overflow_policy> policy{log_overflow_policy::block};
+        std::atomic<std::size_t> dropped{0};
+
+    private:
+        void run()
+        {
+            std::string batch, scratch;
+            std::vector<std::shared_ptr<log_ring>> c_rings;
+            std::size_t reported = 0; // the number of dropped records already reported..
+            std::unique_lock<std::mutex> lock(mtx);
+            while (true)
+            {
+                const auto ticket = flush_requests;
+                const bool stopping = !running;
+                // we remove the rings of the terminated threads..
+                for (auto it = rings.begin(); it != rings.end();)
+                    if (it->use_count() == 1 && (*it)->empty())
+                        it = rings.erase(it);
+                    else
+                        ++it;
+                c_rings = rings;
+                lock.unlock();
+
+                {
+                    std::lock_guard<std::mutex> _(sink_mtx);
+                    for (const auto &ring : c_rings)
+                        ring->drain(scratch, [this, &batch](const char *rec, std::size_t len)
+                                    { consume(batch, rec, len); });
+                    if (const auto c_dropped = dropped.load(std::memory_order_relaxed); c_dropped != reported && !raw)
+                    {
+                        batch += std::to_string(c_dropped - reported) + " log records dropped\n";
+                        reported = c_dropped;
+                    }
+                    if (!batch.empty())
+                    {
+                        sink->write(batch.data(), batch.size());
+                        sink->flush();
+                        batch.clear();
+                    }
+                }
+                c_rings.clear();
+
+                lock.lock();
+                flushed = ticket;
+                flushed_cv.notify_all();
+                if (stopping)
+                    return;
+                if (flush_requests == ticket && running)
+                { // we wait for new records..
+                    sleeping.store(true, std::memory_order_relaxed);
+                    cv.wait_for(lock, std::chrono::milliseconds(50));
+                    sleeping.store(false, std::memory_order_relaxed);
+                }
+            }
+        }
+
+        void consume(std::string &batch, const char *rec, std::size_t len)
+        {
+#ifdef LOGGING_BINARY
+            std::uint32_t id;
+            if (len < sizeof(id))
+                return;
+            std::memcpy(&id, rec, sizeof(id));
+            const auto site = get_log_site(id);
+            if (raw)
+            { // we write the definition of the site, if not already written, and the raw record..
+                if (emitted_sites.size() <= id)
+                    emitted_sites.resize(id + 1, false);
+                if (!emitted_sites[id])
+                {
+                    write_site(batch, id, site);
+                    emitted_sites[id] = true;
+                }
+                batch.push_back(record_frame);
+                append(batch, static_cast<std::uint32_t>(len));
+                batch.append(rec, len);
+            }
+            else
+                format_record(batch, site.file, site.line, site.level, rec + sizeof(id), len - sizeof(id));
+#else
+            batch.append(rec, len);
+#endif
+        }
+
+    private:
+        static std::atomic<bool> destroyed;
+        std::mutex mtx;
+        std::condition_variable cv;
+        std::condition_variable flushed_cv;
+        std::vector<std::shared_ptr<log_ring>> rings; // the rings of the logging threads..
+        std::size_t flush_requests = 0;
+        std::size_t flushed = 0;
+        bool running = true;
+        std::atomic<bool> sleeping{false};
+        std::mutex sink_mtx;
+        std::ostream *sink = &std::cerr;
+        bool raw = false;                // whether the sink receives raw binary records..
+        std::vector<bool> emitted_sites; // the sites whose definition has been written to the raw sink..
+        std::thread th;
+    };
+
+    std::atomic<bool> async_logger::destroyed{false};
+
+    /**
+     * @brief A stream buffer appending to a reusable string.
+     */
+    class line_buf final : public std::streambuf
+    {
+    public:
+        std::string str;
+
+    protected:
+        int_type overflow(int_type c) override
+        {
+            if (c != traits_type::eof())
+                str.push_back(traits_type::to_char_type(c));
+            return c;
+        }
+        std::streamsize xsputn(const char_type *s, std::streamsize n) override
+        {
+            str.append(s, static_cast<std::size_t>(n));
+            return n;
+        }
+    };
+
+    /**
+     * @brief The buffer and the stream of a line being formatted.
+     */
+    struct line_frame final
+    {
+        line_buf buf;
+        std::ostream os{&buf};
+    };
+
+    /**
+     * @brief The logging state of a thread.
+     *
+     * Lines can be formatted while other lines are being formatted (e.g., by an `operator<<` or by a callee which logs), so each nesting level gets its own reusable buffer.
+     */
+    struct thread_log final
+    {
+        std::vector<std::unique_ptr<line_frame>> frames; // the buffers of the lines being formatted, indexed by their nesting level..
+        std::size_t depth = 0;                           // the number of lines being formatted..
+        std::shared_ptr<log_ring> ring;
+
+        /**
+         * @brief Returns the cleared buffer of a new line being formatted.
+         */
+        line_frame &push()
+        {
+            if (depth == frames.size())
+                frames.push_back(std::make_unique<line_frame>());
+            auto &frame = *frames[depth++];
+            frame.buf.str.clear();
+            return frame;
+        }
+    };
+
+    static thread_log &get_thread_log()
+    {
+        thread_local thread_log tl;
+        return tl;
+    }
+
+    /**
+     * @brief Pushes the innermost line formatted by the calling thread into its ring.
+     */
+    static void commit(thread_log &tl, bool sync)
+    {
+        const auto &rec = tl.frames[tl.depth - 1]->buf.str;
+        if (async_logger::is_destroyed())
+        { // the background thread has already been stopped (e.g., during the static destruction), so we write synchronously..
+#ifdef LOGGING_BINARY
+            std::string line;
+            std::uint32_t id;
+            std::memcpy(&id, rec.data(), sizeof(id));
+            const auto site = get_log_site(id);
+            format_record(line, site.file, site.line, site.level, rec.data() + sizeof(id), rec.size() - sizeof(id));
+            std::cerr << line << std::flush;
+#else
+            std::cerr << rec << std::flush;
+#endif
+        }
+        else
+        {
+            auto &logger = async_logger::get_instance();
+            if (!tl.ring)
+                tl.ring = logger.new_ring();
+            logger.push(*tl.ring, rec);
+            if (sync)
+                logger.flush();
+        }
+        --tl.depth;
+    }
+
+    log_line::log_line(bool sync) : os(get_thread_log().push().os), sync(sync) {}
+    log_line::~log_line() { commit(get_thread_log(), sync); }
+
+#ifdef LOGGING_BINARY
+    binary_line::binary_line(std::uint32_t site, bool sync) : buf(get_thread_log().push().buf.str), sync(sync) { append(buf, site); }
+    binary_line::~binary_line() { commit(get_thread_log(), sync); }
+
+    void set_binary_log_sink(std::ostream &sink) noexcept { async_logger::get_instance().set_sink(sink, true); }
+#endif
+
+    void set_log_overflow_policy(log_overflow_policy policy) noexcept { async_logger::get_instance().policy.store(policy, std::memory_order_relaxed); }
+    void set_log_sink(std::ostream &sink) noexcept { async_logger::get_instance().set_sink(sink); }
+    std::size_t dropped_log_records() noexcept { return async_logger::get_instance().dropped.load(std::memory_order_relaxed); }
+    void flush_log() noexcept { async_logger::get_instance().flush(); }
+} // namespace utils
@@ -0,0 +1,396 @@
+#include "sha1.hpp"
+#include "cpu_features.hpp"
+#include <atomic>
+#include <cstdint>
+
+#ifdef UTILS_X86
+#include <immintrin.h>
+#endif
+
+namespace utils
+{
+    static constexpr unsigned int k[4] = {0x5A827999, 0x6ED9EBA1, 0x8F1BBCDC, 0xCA62C1D6};
+
+    static void compress_portable(unsigned int *state, const unsigned char *blocks, size_t n_blocks)
+    {
+        for (; n_blocks; --n_blocks, blocks += 64)
+        {
+            unsigned int w[80];
+            for (size_t i = 0; i < 16; i++)
+            {
+                w[i] = (blocks[i * 4 + 0] << 24);
+                w[i] |= (blocks[i * 4 + 1] << 16);
+                w[i] |= (blocks[i * 4 + 2] << 8);
+                w[i] |= (blocks[i * 4 + 3]);
+            }
+            for (size_t i = 16; i < 80; i++)
+                w[i] = sha1::left_rotate((w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16]), 1);
+
+            unsigned int a = state[0];
+            unsigned int b = state[1];
+            unsigned int c = state[2];
+            unsigned int d = state[3];
+            unsigned int e = state[4];
+
+            for (std::size_t i = 0; i < 80; ++i)
+            {
+                unsigned int f = 0;
+                if (i < 20)
+                    f = (b & c) | (~b & d);
+                else if (i < 40)
+                    f = b ^ c ^ d;
+                else if (i < 60)
+                    f = (b & c) | (b & d) | (c & d);
+                else
+                    f = b ^ c ^ d;
+                unsigned int temp = sha1::left_rotate(a, 5) + f + e + k[i / 20] + w[i];
+                e = d;
+                d = c;
+                c = sha1::left_rotate(b, 30);
+                b = a;
+                a = temp;
+            }
+
+            state[0] += a;
+            state[1] += b;
+            state[2] += c;
+            state[3] += d;
+            state[4] += e;
+        }
+    }
+
+#ifdef UTILS_X86
+    template <int N>
+    UTILS_TARGET("ssse3")
+    static inline __m128i rotl_epi32(__m128i x) noexcept { return _mm_or_si128(_mm_slli_epi32(x, N), _mm_srli_epi32(x, 32 - N)); }
+
+    /**
+     * The message schedule is computed four words at a time. The first 16 expanded words need a fix-up of their last lane, which depends on the first lane of the same vector, while the remaining ones are computed through the equivalent `w[i] = rol2(w[i-6] ^ w[i-16] ^ w[i-28] ^ w[i-32])` recurrence, which has no intra-vector dependency. The rounds are scalar.
+     */
+    UTILS_TARGET("ssse3")
+    static void compress_ssse3(unsigned int *state, const unsigned char *blocks, size_t n_blocks)
+    {
+        const __m128i bswap = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+        alignas(16) unsigned int wk[80];
+        __m128i w[20];
+        for (; n_blocks; --n_blocks, blocks += 64)
+        {
+            for (int i = 0; i < 4; ++i)
+                w[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(blocks + i * 16)), bswap);
+            for (int i = 4; i < 8; ++i)
+            {
+                const __m128i x = _mm_xor_si128(_mm_xor_si128(w[i - 4], _mm_alignr_epi8(w[i - 3], w[i - 4], 8)), _mm_xor_si128(w[i - 2], _mm_srli_si128(w[i - 1], 4)));
+                w[i] = _mm_xor_si128(rotl_epi32<1>(x), rotl_epi32<2>(_mm_slli_si128(x, 12)));
+            }
+            for (int i = 8; i < 20; ++i)
+                w[i] = rotl_epi32<2>(_mm_xor_si128(_mm_xor_si128(_mm_alignr_epi8(w[i - 1], w[i - 2], 8), w[i - 4]), _mm_xor_si128(w[i - 7], w[i - 8])));
+            for (int i = 0; i < 20; ++i)
+                _mm_store_si128(reinterpret_cast<__m128i *>(wk + i * 4), _mm_add_epi32(w[i], _mm_set1_epi32(static_cast<int>(k[i / 5]))));
+
+            unsigned int a = state[0];
+            unsigned int b = state[1];
+            unsigned int c = state[2];
+            unsigned int d = state[3];
+            unsigned int e = state[4];
+            auto round = [&](unsigned int f, unsigned int wk_i) noexcept
+            {
+                unsigned int temp = sha1::left_rotate(a, 5) + f + e + wk_i;
+                e = d;
+                d = c;
+                c = sha1::left_rotate(b, 30);
+                b = a;
+                a = temp;
+            };
+            for (int i = 0; i < 20; ++i)
+                round(d ^ (b & (c ^ d)), wk[i]);
+            for (int i = 20; i < 40; ++i)
+                round(b ^ c ^ d, wk[i]);
+            for (int i = 40; i < 60; ++i)
+                round((b & c) | (d & (b | c)), wk[i]);
+            for (int i = 60; i < 80; ++i)
+                round(b ^ c ^ d, wk[i]);
+
+            state[0] += a;
+            state[1] += b;
+            state[2] += c;
+            state[3] += d;
+            state[4] += e;
+        }
+    }
+
+    /**
+     * Performs the `I`-th group of four rounds, interleaving the message schedule of the following groups.
+     */
+    template <int I>
+    UTILS_TARGET("sha,sse4.1")
+    static inline void sha_ni_rounds(__m128i &abcd, __m128i (&e)[2], __m128i (&m)[4]) noexcept
+    {
+        constexpr int j = I % 4;
+        __m128i &e_cur = e[I % 2];
+        if constexpr (I == 0)
+            e_cur = _mm_add_epi32(e_cur, m[0]);
+        else
+            e_cur = _mm_sha1nexte_epu32(e_cur, m[j]);
+        e[(I + 1) % 2] = abcd;
+        if constexpr (I >= 3 && I <= 18)
+            m[(j + 1) % 4] = _mm_sha1msg2_epu32(m[(j + 1) % 4], m[j]);
+        abcd = _mm_sha1rnds4_epu32(abcd, e_cur, I / 5);
+        if constexpr (I >= 1 && I <= 16)
+            m[(j + 3) % 4] = _mm_sha1msg1_epu32(m[(j + 3) % 4], m[j]);
+        if constexpr (I >= 2 && I <= 17)
+            m[(j + 2) % 4] = _mm_xor_si128(m[(j + 2) % 4], m[j]);
+    }
+
+    template <int... I>
+    UTILS_TARGET("sha,sse4.1")
+    static inline void sha_ni_all_rounds(__m128i &abcd, __m128i (&e)[2], __m128i (&m)[4], std::integer_sequence<int, I...>) noexcept { (sha_ni_rounds<I>(abcd, e, m), ...); }
+
+    UTILS_TARGET("sha,sse4.1")
+    static void compress_sha_ni(unsigned int *state, const unsigned char *blocks, size_t n_blocks)
+    {
+        const __m128i bswap = _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+        __m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(state)), 0x1B);
+        __m128i e0 = _mm_set_epi32(static_cast<int>(state[4]), 0, 0, 0);
+        for (; n_blocks; --n_blocks, blocks += 64)
+        {
+            const __m128i abcd_save = abcd;
+            const __m128i e0_save = e0;
+            __m128i m[4];
+            for (int i = 0; i < 4; ++i)
+                m[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(blocks + i * 16)), bswap);
+            __m128i e[2] = {e0, _mm_setzero_si128()};
+            sha_ni_all_rounds(abcd, e, m, std::make_integer_sequence<int, 20>{});
+            e0 = _mm_sha1nexte_epu32(e[0], e0_save);
+            abcd = _mm_add_epi32(abcd, abcd_save);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(state), _mm_shuffle_epi32(abcd, 0x1B));
+        state[4] = static_cast<unsigned int>(_mm_extract_epi32(e0, 3));
+    }
+#endif
+
+    sha1_compress_fn get_sha1_compress(sha1_backend backend) noexcept
+    {
+        switch (backend)
+        {
+        case sha1_backend::portable:
+            return compress_portable;
+#ifdef UTILS_X86
+        case sha1_backend::ssse3:
+            return get_cpu_features().ssse3 ? compress_ssse3 : nullptr;
+        case sha1_backend::sha_ni:
+            return get_cpu_features().sha && get_cpu_features().sse41 ? compress_sha_ni : nullptr;
+#endif
+        default:
+            return nullptr;
+        }
+    }
+
+    static sha1_backend best_sha1_backend() noexcept
+    {
+        if (get_sha1_compress(sha1_backend::sha_ni))
+            return sha1_backend::sha_ni;
+        if (get_sha1_compress(sha1_backend::ssse3))
+            return sha1_backend::ssse3;
+        return sha1_backend::portable;
+    }
+
+    struct sha1_dispatch
+    {
+        std::atomic<sha1_backend> backend{best_sha1_backend()};
+        std::atomic<sha1_compress_fn> compress{get_sha1_compress(backend.load())};
+    };
+
+    static sha1_dispatch &get_dispatch() noexcept
+    {
+        static sha1_dispatch dispatch;
+        return dispatch;
+    }
+
+    sha1_backend get_sha1_backend() noexcept { return get_dispatch().backend.load(std::memory_order_relaxed); }
+
+    bool set_sha1_backend(sha1_backend backend) noexcept
+    {
+        const auto compress = get_sha1_compress(backend);
+        if (!compress)
+            return false;
+        get_dispatch().backend.store(backend, std::memory_order_relaxed);
+        get_dispatch().compress.store(compress, std::memory_order_relaxed);
+        return true;
+    }
+
+    void sha1_compress(unsigned int *state, const unsigned char *blocks, size_t n_blocks) noexcept { get_dispatch().compress.load(std::memory_order_relaxed)(state, blocks, n_blocks); }
+
+    static void sha1_batch_serial(const std::string_view *messages, size_t count, sha1::digest_8 *digests)
+    {
+        for (size_t i = 0; i < count; ++i)
+            sha1(messages[i]).get_digest_bytes(digests[i]);
+    }
+
+#if defined(UTILS_X86) && defined(__GNUC__)
+    /**
+     * The multi-buffer kernels are written once on top of the GCC vector extensions, so that each instantiation is compiled for the instruction set of the function it is inlined into.
+     */
+    typedef std::uint32_t u32x8 __attribute__((vector_size(32)));
+    typedef std::uint32_t u32x16 __attribute__((vector_size(64)));
+
+#define SHA1_MB_ROTL(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+#define SHA1_MB_ROUND(f, t)                                                                                           \
+    {                                                                                                                 \
+        if (t >= 16)                                                                                                  \
+            w[t & 15] = SHA1_MB_ROTL(w[(t - 3) & 15] ^ w[(t - 8) & 15] ^ w[(t - 14) & 15] ^ w[t & 15], 1);            \
+        const V temp = SHA1_MB_ROTL(a, 5) + (f) + e + k[t / 20] + w[t & 15];                                          \
+        e = d;                                                                                                        \
+        d = c;                                                                                                        \
+        c = SHA1_MB_ROTL(b, 30);                                                                                      \
+        b = a;                                                                                                        \
+        a = temp;                                                                                                     \
+    }
+
+    /**
+     * Compresses one block for each of the `L` lanes. The state and the message words are transposed, so that the `i`-th word of all the lanes is contiguous.
+     */
+    template <typename V, size_t L>
+    __attribute__((always_inline)) inline void sha1_mb_compress(std::uint32_t *state, const std::uint32_t *words) noexcept
+    {
+        V w[16];
+        for (size_t t = 0; t < 16; ++t)
+            memcpy(&w[t], words + t * L, sizeof(V));
+        V s[5];
+        for (size_t i = 0; i < 5; ++i)
+            memcpy(&s[i], state + i * L, sizeof(V));
+        V a = s[0], b = s[1], c = s[2], d = s[3], e = s[4];
+
+        for (size_t t = 0; t < 20; ++t)
+            SHA1_MB_ROUND(d ^ (b & (c ^ d)), t);
+        for (size_t t = 20; t < 40; ++t)
+            SHA1_MB_ROUND(b ^ c ^ d, t);
+        for (size_t t = 40; t < 60; ++t)
+            SHA1_MB_ROUND((b & c) | (d & (b | c)), t);
+        for (size_t t = 60; t < 80; ++t)
+            SHA1_MB_ROUND(b ^ c ^ d, t);
+
+        s[0] += a;
+        s[1] += b;
+        s[2] += c;
+        s[3] += d;
+        s[4] += e;
+        for (size_t i = 0; i < 5; ++i)
+            memcpy(state + i * L, &s[i], sizeof(V));
+    }
+#undef SHA1_MB_ROUND
+#undef SHA1_MB_ROTL
+
+    UTILS_TARGET("avx2")
+    static void sha1_mb_compress_avx2(std::uint32_t *state, const std::uint32_t *words) noexcept { sha1_mb_compress<u32x8, 8>(state, words); }
+    UTILS_TARGET("avx512f")
+    static void sha1_mb_compress_avx512(std::uint32_t *state, const std::uint32_t *words) noexcept { sha1_mb_compress<u32x16, 16>(state, words); }
+
+    /**
+     * Schedules the messages on `L` lanes. Each lane first compresses the whole blocks of its message, straight from the caller's buffer, and then its padded blocks. Idle lanes compress a dummy block, whose result is discarded.
+     */
+    template <size_t L>
+    static void sha1_mb(void (*compress)(std::uint32_t *, const std::uint32_t *) noexcept, const std::string_view *messages, size_t count, sha1::digest_8 *digests)
+    {
+        struct lane
+        {
+            const unsigned char *data; // the next whole block of the message..
+            size_t blocks;             // the number of whole blocks left..
+            size_t padded_blocks;      // the number of padded blocks, until the lane moves on to them..
+            size_t message;            // the index of the message, or `count` for idle lanes..
+            unsigned char padded[128];
+        };
+        static constexpr std::uint32_t h0[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+        static constexpr unsigned char dummy[64] = {};
+
+        lane lanes[L];
+        alignas(64) std::uint32_t state[5 * L];
+        alignas(64) std::uint32_t words[16 * L];
+        size_t next = 0, active = 0;
+        const auto assign = [&](size_t l)
+        {
+            lane &ln = lanes[l];
+            ln.message = next < count ? next++ : count;
+            if (ln.message == count)
+                return false;
+            const auto data = reinterpret_cast<const unsigned char *>(messages[ln.message].data());
+            const size_t size = messages[ln.message].size();
+            ln.data = data;
+            ln.blocks = size / 64;
+            ln.padded_blocks = sha1::pad(data + ln.blocks * 64, size, ln.padded);
+            for (size_t i = 0; i < 5; ++i)
+                state[i * L + l] = h0[i];
+            return true;
+        };
+        for (size_t l = 0; l < L; ++l)
+            if (assign(l))
+                ++active;
+
+        while (active)
+        {
+            for (size_t l = 0; l < L; ++l)
+            { // we transpose the next block of each lane, converting its words from big endian..
+                lane &ln = lanes[l];
+                const unsigned char *blk = dummy;
+                if (ln.message != count)
+                {
+                    if (!ln.blocks)
+                    { // we move on to the padded blocks..
+                        ln.data = ln.padded;
+                        ln.blocks = ln.padded_blocks;
+                        ln.padded_blocks = 0;
+                    }
+                    blk = ln.data;
+                    ln.data += 64;
+                    --ln.blocks;
+                }
+                for (size_t t = 0; t < 16; ++t)
+                    words[t * L + l] = (std::uint32_t(blk[t * 4]) << 24) | (std::uint32_t(blk[t * 4 + 1]) << 16) | (std::uint32_t(blk[t * 4 + 2]) << 8) | std::uint32_t(blk[t * 4 + 3]);
+            }
+            compress(state, words);
+            for (size_t l = 0; l < L; ++l)
+            {
+                lane &ln = lanes[l];
+                if (ln.message == count || ln.blocks || ln.padded_blocks)
+                    continue;
+                for (size_t i = 0; i < 5; ++i)
+                    for (size_t j = 0; j < 4; ++j)
+                        digests[ln.message][i * 4 + j] = static_cast<unsigned char>(state[i * L + l] >> (24 - j * 8));
+                if (!assign(l))
+                    --active;
+            }
+        }
+    }
+
+    static void sha1_batch_avx2(const std::string_view *messages, size_t count, sha1::digest_8 *digests) { sha1_mb<8>(sha1_mb_compress_avx2, messages, count, digests); }
+    static void sha1_batch_avx512(const std::string_view *messages, size_t count, sha1::digest_8 *digests) { sha1_mb<16>(sha1_mb_compress_avx512, messages, count, digests); }
+#endif
+
+    sha1_batch_fn get_sha1_batch(sha1_batch_backend backend) noexcept
+    {
+        switch (backend)
+        {
+        case sha1_batch_backend::serial:
+            return sha1_batch_serial;
+#if defined(UTILS_X86) && defined(__GNUC__)
+        case sha1_batch_backend::avx2:
+            return get_cpu_features().avx2 ? sha1_batch_avx2 : nullptr;
+        case sha1_batch_backend::avx512:
+            return get_cpu_features().avx512f ? sha1_batch_avx512 : nullptr;
+#endif
+        default:
+            return nullptr;
+        }
+    }
+
+    void sha1_batch(const std::string_view *messages, size_t count, sha1::digest_8 *digests) noexcept
+    {
+        static const sha1_batch_fn batch = []()
+        {
+            for (auto backend : {sha1_batch_backend::avx512, sha1_batch_backend::avx2})
+                if (auto fn = get_sha1_batch(backend))
+                    return fn;
+            return get_sha1_batch(sha1_batch_backend::serial);
+        }();
+        batch(messages, count, digests);
+    }
+} // namespace utils
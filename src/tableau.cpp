@@ -1,5 +1,6 @@
 #include <cassert>
 #include "tableau.hpp"
+#include "instrumentation.hpp"
 
 namespace utils
 {
@@ -22,6 +23,8 @@ namespace utils
         assert(table.find(x_i) != table.cend() && "x_i is not a basic variable");
         assert(watches[x_i].empty() && "x_i is should not be in any other row of the tableau");
         assert(table.find(y_j) == table.cend() && "y_j is not a non-basic variable");
+        UTILS_COUNT("tableau.pivots");
+        UTILS_SCOPED_TIMER("tableau.pivot");
 
         // we remove the leaving variable `x_i` from the watches
         for (const auto &x : table[x_i].vars)
@@ -36,6 +39,7 @@ namespace utils
         table.erase(x_i);
 
         // we update the rows that contain `y_j`
+        UTILS_RECORD("tableau.pivot_rows", watches[y_j].size());
         for (auto &x : watches[y_j])
         {
             c = table[x].vars.at(y_j);
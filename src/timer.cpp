@@ -1,28 +1,271 @@
 #include "timer.hpp"
-#include <chrono>
+#include "instrumentation.hpp"
+#include <algorithm>
+#include <utility>
 
 namespace utils
 {
-    timer::timer(const size_t &tick_dur, std::function<void(void)> f) : tick_duration(tick_dur), fun(f) {}
+    timer_wheel::timer_wheel(const size_t &resolution) : resolution(std::max<size_t>(resolution, 1)), origin(std::chrono::steady_clock::now()), th([this]()
+                                                                                                                                                 { run(); }) {}
+    timer_wheel::~timer_wheel()
+    {
+        {
+            std::lock_guard<std::mutex> _(mtx);
+            running = false;
+        }
+        cv.notify_one();
+        th.join();
+    }
+
+    timer_wheel::timer_id timer_wheel::schedule(const size_t &delay, std::function<void(void)> f, const size_t &period, const overrun_policy &policy)
+    {
+        std::lock_guard<std::mutex> _(mtx);
+        const auto now = now_tick();
+        if (entries.empty() && now > current)
+            current = now; // the wheel is idle, so we can skip the elapsed ticks..
+        const auto id = next_id++;
+        auto &e = entries.emplace(id, entry{id, now + ticks(delay), period ? std::max<uint64_t>(ticks(period), 1) : 0, std::move(f), policy}).first->second;
+        add(e);
+        cv.notify_one();
+        return id;
+    }
+
+    bool timer_wheel::cancel(const timer_id &id)
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        if (executing == id)
+        { // the callback is being executed, so we prevent the timer from being rescheduled..
+            entries.at(id).cancelled = true;
+            if (std::this_thread::get_id() != th.get_id()) // the timer is not cancelling itself from within its callback..
+                done_cv.wait(lock, [this, &id]()
+                             { return executing != id; });
+            return true;
+        }
+        auto it = entries.find(id);
+        if (it == entries.end())
+            return false;
+        unlink(it->second);
+        entries.erase(it);
+        return true;
+    }
+
+    timer_stats timer_wheel::get_stats(const timer_id &id)
+    {
+        std::lock_guard<std::mutex> _(mtx);
+        if (auto it = entries.find(id); it != entries.end())
+            return it->second.stats;
+        return timer_stats();
+    }
+
+    size_t timer_wheel::size()
+    {
+        std::lock_guard<std::mutex> _(mtx);
+        return entries.size();
+    }
+
+    timer_wheel &timer_wheel::get_default()
+    {
+        static timer_wheel wheel;
+        return wheel;
+    }
+
+    void timer_wheel::add(entry &e) noexcept
+    {
+        const uint64_t delta = e.expires - current;
+        entry **slot;
+        if (e.expires < current)
+        { // the timer is already expired, so we put it in the next slot to be processed..
+            slot = &root[current & (root.size() - 1)];
+            e.in_first_level = true;
+        }
+        else if (delta < root.size())
+        {
+            slot = &root[e.expires & (root.size() - 1)];
+            e.in_first_level = true;
+        }
+        else
+        {
+            size_t level = 0;
+            while (level < levels - 1 && delta >= uint64_t(1) << (root_bits + (level + 1) * level_bits))
+                ++level;
+            // timers beyond the range of the wheel are put in the farthest slot and are re-hashed when cascaded..
+            const uint64_t at = delta < uint64_t(1) << (root_bits + levels * level_bits) ? e.expires : current + (uint64_t(1) << (root_bits + levels * level_bits)) - 1;
+            slot = &upper[level][(at >> (root_bits + level * level_bits)) & ((1 << level_bits) - 1)];
+        }
+        if (e.in_first_level)
+            ++root_size;
+
+        e.next = *slot;
+        if (e.next)
+            e.next->pprev = &e.next;
+        *slot = &e;
+        e.pprev = slot;
+    }
+
+    void timer_wheel::unlink(entry &e) noexcept
+    {
+        if (!e.pprev)
+            return;
+        *e.pprev = e.next;
+        if (e.next)
+            e.next->pprev = e.pprev;
+        e.next = nullptr;
+        e.pprev = nullptr;
+        if (e.in_first_level)
+        {
+            e.in_first_level = false;
+            --root_size;
+        }
+    }
+
+    void timer_wheel::cascade(const size_t &level) noexcept
+    {
+        auto &slot = upper[level][(current >> (root_bits + level * level_bits)) & ((1 << level_bits) - 1)];
+        entry *e = slot;
+        slot = nullptr;
+        while (e)
+        {
+            entry *next = e->next;
+            e->next = nullptr;
+            e->pprev = nullptr;
+            add(*e);
+            e = next;
+        }
+    }
+
+    void timer_wheel::step() noexcept
+    {
+        const size_t idx = current & (root.size() - 1);
+        if (idx == 0) // we cascade the timers of the upper levels which expire within the next round of the first level..
+            for (size_t level = 0; level < levels; ++level)
+            {
+                cascade(level);
+                if ((current >> (root_bits + level * level_bits)) & ((1 << level_bits) - 1))
+                    break;
+            }
+        ++current;
+
+        // we move the expired timers into the pending list..
+        while (root[idx])
+        {
+            entry &e = *root[idx];
+            unlink(e);
+            e.next = pending;
+            if (pending)
+                pending->pprev = &e.next;
+            pending = &e;
+            e.pprev = &pending;
+        }
+    }
+
+    void timer_wheel::reschedule(entry &e) noexcept
+    {
+        e.expires += e.period;
+        const auto now = now_tick();
+        if (e.expires <= now)
+        { // the callback has overrun the period of the timer..
+            ++e.stats.overruns;
+            const uint64_t missed = (now - e.expires) / e.period + 1; // the number of ticks which are already due..
+            switch (e.policy)
+            {
+            case overrun_policy::catch_up: // the due ticks will be executed back-to-back..
+                break;
+            case overrun_policy::skip: // the due ticks are dropped..
+                e.stats.missed_ticks += missed;
+                e.expires += missed * e.period;
+                break;
+            case overrun_policy::coalesce: // the due ticks are collapsed into the last one, which is executed immediately..
+                e.stats.missed_ticks += missed - 1;
+                e.expires += (missed - 1) * e.period;
+                break;
+            }
+        }
+        add(e);
+    }
+
+    void timer_wheel::run()
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        while (running)
+        {
+            if (entries.empty())
+            {
+                cv.wait(lock);
+                continue;
+            }
+
+            // if the first level is empty, nothing can expire before the next cascade..
+            const uint64_t next = (root_size || (current & (root.size() - 1)) == 0) ? current : ((current >> root_bits) + 1) << root_bits;
+            const auto next_time = origin + resolution * static_cast<std::chrono::milliseconds::rep>(next);
+            if (std::chrono::steady_clock::now() < next_time)
+            {
+                cv.wait_until(lock, next_time);
+                continue;
+            }
+
+            step();
+            while (pending)
+            {
+                entry &e = *pending;
+                unlink(e);
+                executing = e.id;
+                lock.unlock();
+                const auto start = std::chrono::steady_clock::now();
+                e.fun(); // execute the callback function
+                const auto end = std::chrono::steady_clock::now();
+                UTILS_COUNT("timer.callbacks");
+                UTILS_RECORD("timer.callback_ns", static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+                lock.lock();
+                executing = 0;
+
+                // we update the statistics of the timer..
+                const auto jitter = std::chrono::duration_cast<std::chrono::microseconds>(start - (origin + resolution * static_cast<std::chrono::milliseconds::rep>(e.expires)));
+                const auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+                ++e.stats.ticks;
+                e.stats.last_jitter = jitter;
+                e.stats.max_jitter = std::max(e.stats.max_jitter, jitter);
+                e.stats.total_jitter += jitter;
+                e.stats.max_duration = std::max(e.stats.max_duration, duration);
+                size_t bucket = 0;
+                for (auto us = duration.count(); us > 0 && bucket < timer_stats::histogram_size - 1; us >>= 1)
+                    ++bucket;
+                ++e.stats.duration_histogram[bucket];
+
+                if (e.period && !e.cancelled)
+                    reschedule(e);
+                else
+                    entries.erase(e.id);
+                done_cv.notify_all();
+            }
+        }
+    }
+
+    timer::timer(const size_t &tick_dur, std::function<void(void)> f, const overrun_policy &policy) : timer(timer_wheel::get_default(), tick_dur, std::move(f), policy) {}
+    timer::timer(timer_wheel &wheel, const size_t &tick_dur, std::function<void(void)> f, const overrun_policy &policy) : wheel(wheel), tick_duration(tick_dur), fun(std::move(f)), policy(policy) {}
 
     void timer::start()
     {
-        executing.store(true, std::memory_order_release);
-        tick_time = std::chrono::steady_clock::now() + std::chrono::milliseconds(tick_duration);
-        th = std::thread([this]()
-                         {
-            while (executing.load(std::memory_order_acquire)) {
-                fun(); // execute the callback function
-                std::this_thread::sleep_until(tick_time); // sleep until the next tick
-                tick_time += std::chrono::milliseconds(tick_duration); // update the tick time
-            } });
+        std::lock_guard<std::mutex> _(mtx);
+        if (!id)
+            id = wheel.schedule(0, [this]()
+                                { fun(); }, tick_duration, policy);
     }
 
     void timer::stop()
     {
-        executing.store(false, std::memory_order_release);
+        timer_wheel::timer_id c_id;
+        {
+            std::lock_guard<std::mutex> _(mtx);
+            c_id = std::exchange(id, 0);
+        }
+        // the lock is released while waiting for a running callback, which might call `get_stats` or `start` on this timer..
+        if (c_id)
+            wheel.cancel(c_id);
+    }
+
+    timer_stats timer::get_stats()
+    {
         std::lock_guard<std::mutex> _(mtx);
-        if (th.joinable())
-            th.join();
+        return id ? wheel.get_stats(id) : timer_stats();
     }
-} // namespace utils
\ No newline at end of file
+} // namespace utils
@@ -1,7 +1,20 @@
 #include <cassert>
 #include <cstdint>
+#include <algorithm>
+#include <array>
+#include <vector>
+#include <sstream>
 #include "sha1.hpp"
 #include "base64.hpp"
+#ifdef UTILS_ENABLE_CRYPTO
+#include <thread>
+#include <atomic>
+#include <stdexcept>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/rsa.h>
+#include "crypto.hpp"
+#endif
 
 void test_sha1()
 {
@@ -13,9 +26,493 @@ void test_sha1()
     assert(encoded == "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=");
 }
 
+std::string to_hex(const unsigned char *data, size_t len)
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string hex;
+    for (size_t i = 0; i < len; ++i)
+    {
+        hex += digits[data[i] >> 4];
+        hex += digits[data[i] & 0xF];
+    }
+    return hex;
+}
+
+void test_sha1_streaming()
+{
+    uint8_t digest[20];
+
+    utils::sha1 empty;
+    empty.get_digest_bytes(digest);
+    assert(to_hex(digest, 20) == "da39a3ee5e6b4b0d3255bfef95601890afd80709");
+
+    utils::sha1 abc("abc");
+    abc.get_digest_bytes(digest);
+    assert(to_hex(digest, 20) == "a9993e364706816aba3e25717850c26c9cd0d89d");
+    abc.get_digest_bytes(digest); // the digest can be retrieved more than once..
+    assert(to_hex(digest, 20) == "a9993e364706816aba3e25717850c26c9cd0d89d");
+
+    utils::sha1 million;
+    const std::string chunk(1000, 'a');
+    for (size_t i = 0; i < 1000; ++i)
+        million.update(chunk);
+    million.get_digest_bytes(digest);
+    assert(to_hex(digest, 20) == "34aa973cd4c4daa4f61eeb2bdbad27316534016f");
+
+    // arbitrary chunk boundaries produce the same digest..
+    std::string data;
+    for (size_t i = 0; i < 1000; ++i)
+        data += static_cast<char>(i * 31 + 7);
+    for (size_t len = 0; len <= data.size(); len += 37)
+    {
+        uint8_t expected[20];
+        utils::sha1(std::string_view(data.data(), len)).get_digest_bytes(expected);
+        for (size_t step : {1, 13, 63, 64, 65, 200})
+        {
+            utils::sha1 sha;
+            for (size_t pos = 0; pos < len; pos += step)
+                sha.update(data.data() + pos, std::min(step, len - pos));
+            sha.get_digest_bytes(digest);
+            assert(memcmp(digest, expected, 20) == 0);
+        }
+    }
+}
+
+void test_sha1_backends()
+{
+    std::string data;
+    for (size_t i = 0; i < 64 * 37 + 11; ++i)
+        data += static_cast<char>(i * 131 + (i >> 7));
+
+    const auto portable = utils::get_sha1_compress(utils::sha1_backend::portable);
+    assert(portable);
+
+    const auto selected = utils::get_sha1_backend();
+    for (auto backend : {utils::sha1_backend::portable, utils::sha1_backend::ssse3, utils::sha1_backend::sha_ni})
+    {
+        const auto compress = utils::get_sha1_compress(backend);
+        if (!compress) // not supported by this CPU..
+        {
+            [[maybe_unused]] const bool set = utils::set_sha1_backend(backend);
+            assert(!set);
+            continue;
+        }
+
+        // the raw compression is bit-identical to the portable one, for any number of blocks..
+        for (size_t n_blocks = 1; n_blocks <= 37; n_blocks += 4)
+        {
+            unsigned int expected[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+            unsigned int state[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+            portable(expected, reinterpret_cast<const unsigned char *>(data.data()), n_blocks);
+            compress(state, reinterpret_cast<const unsigned char *>(data.data()), n_blocks);
+            assert(memcmp(state, expected, sizeof(state)) == 0);
+        }
+
+        [[maybe_unused]] const bool set = utils::set_sha1_backend(backend);
+        assert(set);
+        assert(utils::get_sha1_backend() == backend);
+        uint8_t digest[20];
+        utils::sha1("abc").get_digest_bytes(digest);
+        assert(to_hex(digest, 20) == "a9993e364706816aba3e25717850c26c9cd0d89d");
+        utils::sha1("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq").get_digest_bytes(digest);
+        assert(to_hex(digest, 20) == "84983e441c3bd26ebaae4aa1f95129e5e54670f1");
+        utils::sha1(std::string(1000000, 'a')).get_digest_bytes(digest);
+        assert(to_hex(digest, 20) == "34aa973cd4c4daa4f61eeb2bdbad27316534016f");
+    }
+    utils::set_sha1_backend(selected);
+}
+
+void test_sha1_batch()
+{
+    std::string data;
+    for (size_t i = 0; i < 5000; ++i)
+        data += static_cast<char>(i * 97 + (i >> 5));
+
+    // messages of uneven lengths, crossing the padding boundaries, so that lanes are refilled at different times..
+    std::vector<std::string_view> messages;
+    for (size_t i = 0; i < 300; ++i)
+        messages.emplace_back(data.data() + i, (i * 37) % 200 + (i % 11 == 0 ? 4000 : 0));
+    for (size_t len : {0, 55, 56, 63, 64, 65, 119, 120, 128})
+        messages.emplace_back(data.data(), len);
+
+    std::vector<std::array<unsigned char, 20>> expected(messages.size());
+    for (size_t i = 0; i < messages.size(); ++i)
+        utils::sha1(messages[i]).get_digest_bytes(expected[i].data());
+
+    for (auto backend : {utils::sha1_batch_backend::serial, utils::sha1_batch_backend::avx2, utils::sha1_batch_backend::avx512})
+    {
+        const auto batch = utils::get_sha1_batch(backend);
+        if (!batch) // not supported by this CPU..
+            continue;
+        for (size_t count : {size_t(0), size_t(1), size_t(7), size_t(17), messages.size()})
+        {
+            std::vector<std::array<unsigned char, 20>> digests(count);
+            batch(messages.data(), count, reinterpret_cast<utils::sha1::digest_8 *>(digests.data()));
+            for (size_t i = 0; i < count; ++i)
+                assert(digests[i] == expected[i]);
+        }
+    }
+
+    std::vector<std::array<unsigned char, 20>> digests(messages.size());
+    utils::sha1_batch(messages.data(), messages.size(), reinterpret_cast<utils::sha1::digest_8 *>(digests.data()));
+    assert(digests == expected);
+}
+
+void test_base64()
+{
+    // RFC 4648 test vectors..
+    const std::pair<std::string, std::string> vectors[] = {{"", ""}, {"f", "Zg=="}, {"fo", "Zm8="}, {"foo", "Zm9v"}, {"foob", "Zm9vYg=="}, {"fooba", "Zm9vYmE="}, {"foobar", "Zm9vYmFy"}};
+    for ([[maybe_unused]] const auto &[plain, encoded] : vectors)
+    {
+        assert(utils::base64_encode(reinterpret_cast<const unsigned char *>(plain.data()), plain.size()) == encoded);
+        assert(utils::base64_decode(encoded) == plain);
+        assert(utils::base64url_decode(encoded.substr(0, encoded.find('='))) == plain); // unpadded..
+    }
+    assert(utils::base64url_encode(std::string("\xfb\xff\xbf")) == "-_-_");
+    assert(utils::base64url_decode("-_-_") == "\xfb\xff\xbf");
+
+    std::string data;
+    for (size_t i = 0; i < 300; ++i)
+        data += static_cast<char>(i * 167 + (i >> 3));
+
+    const auto selected = utils::get_base64_backend();
+    utils::set_base64_backend(utils::base64_backend::portable);
+    std::vector<std::string> expected, expected_url;
+    for (size_t len = 0; len <= data.size(); ++len)
+    {
+        expected.push_back(utils::base64_encode(reinterpret_cast<const unsigned char *>(data.data()), len));
+        expected_url.push_back(utils::base64url_encode(data.substr(0, len)));
+    }
+
+    for (auto backend : {utils::base64_backend::portable, utils::base64_backend::ssse3, utils::base64_backend::avx2})
+    {
+        if (!utils::set_base64_backend(backend)) // not supported by this CPU..
+            continue;
+        for (size_t len = 0; len <= data.size(); ++len)
+        {
+            const std::string plain = data.substr(0, len);
+            const std::string encoded = utils::base64_encode(reinterpret_cast<const unsigned char *>(plain.data()), len);
+            const std::string encoded_url = utils::base64url_encode(plain);
+            assert(encoded == expected[len]);
+            assert(encoded_url == expected_url[len]);
+            assert(encoded.size() == utils::base64_encoded_size(len));
+            assert(encoded_url.size() == utils::base64_encoded_size(len, utils::base64_alphabet::url));
+            assert(utils::base64_decode(encoded) == plain);
+            assert(utils::base64url_decode(encoded_url) == plain);
+
+            // invalid characters are detected anywhere in the input..
+            for (size_t pos = 0; pos < encoded_url.size(); pos += 7)
+                for (char bad : {'=', '+', '\x80', '\0', ' '})
+                {
+                    if (bad == '=' && pos + 2 >= encoded_url.size()) // that would be a valid padding..
+                        continue;
+                    std::string corrupted = encoded_url;
+                    corrupted[pos] = bad;
+                    std::vector<unsigned char> out(utils::base64_decoded_max_size(corrupted.size()));
+                    assert(utils::base64_decode(corrupted.data(), corrupted.size(), out.data(), utils::base64_alphabet::url) == utils::base64_invalid);
+                }
+        }
+    }
+    utils::set_base64_backend(selected);
+
+    // invalid lengths and misplaced padding..
+    [[maybe_unused]] unsigned char out[8];
+    assert(utils::base64_decode("Zm9vY", 5, out) == utils::base64_invalid);
+    assert(utils::base64_decode("Zg=", 3, out) == utils::base64_invalid);
+    assert(utils::base64_decode("====", 4, out) == utils::base64_invalid);
+    assert(utils::base64_decode("Zg==Zg==", 8, out) == utils::base64_invalid);
+    [[maybe_unused]] bool thrown = false;
+    try
+    {
+        [[maybe_unused]] auto decoded = utils::base64_decode("Zm9v!");
+    }
+    catch (const std::invalid_argument &)
+    {
+        thrown = true;
+    }
+    assert(thrown);
+}
+
+void test_base64_streaming()
+{
+    std::string data;
+    for (size_t i = 0; i < 1000; ++i)
+        data += static_cast<char>(i * 151 + (i >> 4));
+
+    for (auto alphabet : {utils::base64_alphabet::standard, utils::base64_alphabet::url})
+        for (size_t len : {0, 1, 2, 3, 4, 5, 100, 1000})
+        {
+            const std::string plain = data.substr(0, len);
+            std::string expected(utils::base64_encoded_size(len, alphabet), '\0');
+            utils::base64_encode(reinterpret_cast<const unsigned char *>(plain.data()), len, expected.data(), alphabet);
+
+            for (size_t chunk : {1, 2, 5, 64, 333})
+                for (size_t capacity : {4, 7, 100})
+                {
+                    // encoding, with arbitrary chunks and bounded output buffers..
+                    utils::base64_encoder encoder(alphabet);
+                    std::string encoded;
+                    std::vector<char> out(capacity);
+                    for (size_t pos = 0; pos < len;)
+                    {
+                        const size_t n = std::min(chunk, len - pos);
+                        const auto step = encoder.update(reinterpret_cast<const unsigned char *>(plain.data()) + pos, n, out.data(), capacity);
+                        assert(step.written <= capacity);
+                        assert(step.consumed || step.written || n < 3); // progress..
+                        encoded.append(out.data(), step.written);
+                        pos += step.consumed;
+                    }
+                    encoded.append(out.data(), encoder.finish(out.data()));
+                    assert(encoded == expected);
+
+                    // decoding, with arbitrary chunks and bounded output buffers..
+                    utils::base64_decoder decoder(alphabet);
+                    std::string decoded;
+                    std::vector<unsigned char> bytes(std::max(capacity, utils::base64_decoder::max_finish_size));
+                    for (size_t pos = 0; pos < encoded.size();)
+                    {
+                        const size_t n = std::min(chunk, encoded.size() - pos);
+                        const auto step = decoder.update(encoded.data() + pos, n, bytes.data(), capacity);
+                        assert(step.written <= capacity);
+                        decoded.append(reinterpret_cast<const char *>(bytes.data()), step.written);
+                        pos += step.consumed;
+                    }
+                    const size_t last = decoder.finish(bytes.data());
+                    assert(last != utils::base64_invalid);
+                    decoded.append(reinterpret_cast<const char *>(bytes.data()), last);
+                    assert(decoded == plain);
+                }
+        }
+
+    // padding is only allowed at the end of the stream..
+    utils::base64_decoder decoder;
+    unsigned char out[16];
+    const std::string padded_twice = "Zg==Zg==";
+    for (char c : padded_twice)
+        decoder.update(&c, 1, out, sizeof(out));
+    assert(decoder.failed());
+    [[maybe_unused]] const size_t finished = decoder.finish(out); // outside of the assert, as it resets the decoder..
+    assert(finished == utils::base64_invalid);
+    assert(!decoder.failed());
+    const std::string bad = "Zm9v!m9v";
+    decoder.update(bad.data(), bad.size(), out, sizeof(out));
+    [[maybe_unused]] const size_t finished_bad = decoder.finish(out);
+    assert(finished_bad == utils::base64_invalid);
+
+    // whole streams, through fixed size buffers..
+    std::string big;
+    for (size_t i = 0; i < 100000; ++i)
+        big += static_cast<char>(i * 31 + (i >> 8));
+    std::istringstream plain_in(big);
+    std::ostringstream encoded_out;
+    utils::base64_encode(plain_in, encoded_out);
+    assert(encoded_out.str() == utils::base64_encode(reinterpret_cast<const unsigned char *>(big.data()), big.size()));
+    std::istringstream encoded_in(encoded_out.str());
+    std::ostringstream decoded_out;
+    [[maybe_unused]] const bool decoded = utils::base64_decode(encoded_in, decoded_out);
+    assert(decoded);
+    assert(decoded_out.str() == big);
+    std::istringstream bad_in("Zm9v*");
+    std::ostringstream bad_out;
+    [[maybe_unused]] const bool bad_decoded = utils::base64_decode(bad_in, bad_out);
+    assert(!bad_decoded);
+}
+
+#ifdef UTILS_ENABLE_CRYPTO
+std::string generate_private_key()
+{
+    EVP_PKEY *pkey = EVP_RSA_gen(2048);
+    BIO *bio = BIO_new(BIO_s_mem());
+    PEM_write_bio_PrivateKey(bio, pkey, nullptr, nullptr, 0, nullptr, nullptr);
+    char *pem_data;
+    long pem_len = BIO_get_mem_data(bio, &pem_data);
+    std::string pem(pem_data, pem_len);
+    BIO_free(bio);
+    EVP_PKEY_free(pkey);
+    return pem;
+}
+
+bool verify_rs256(std::string_view data, std::string_view signature, std::string_view public_key_pem)
+{
+    BIO *bio = BIO_new_mem_buf(public_key_pem.data(), static_cast<int>(public_key_pem.size()));
+    EVP_PKEY *pkey = PEM_read_bio_PUBKEY(bio, nullptr, nullptr, nullptr);
+    BIO_free(bio);
+    EVP_MD_CTX *ctx = EVP_MD_CTX_new();
+    const bool valid = EVP_DigestVerifyInit(ctx, nullptr, EVP_sha256(), nullptr, pkey) == 1 && EVP_DigestVerify(ctx, reinterpret_cast<const unsigned char *>(signature.data()), signature.size(), reinterpret_cast<const unsigned char *>(data.data()), data.size()) == 1;
+    EVP_MD_CTX_free(ctx);
+    EVP_PKEY_free(pkey);
+    return valid;
+}
+
+void test_rs256_signer()
+{
+    const std::string private_key = generate_private_key();
+    const std::string public_key = utils::extract_public_key(private_key);
+    const utils::rs256_signer signer(private_key);
+
+    const std::string signature = signer.sign("header.payload");
+    assert(signature.size() == 256);
+    assert(verify_rs256("header.payload", signature, public_key));
+    assert(!verify_rs256("header.payload!", signature, public_key));
+    assert(utils::sign_rs256("header.payload", private_key) == signature); // PKCS #1 v1.5 signatures are deterministic..
+    assert(utils::sign_rs256("header.payload", private_key) == signature); // through the cached signer..
+
+    std::vector<std::string> messages;
+    for (size_t i = 0; i < 20; ++i)
+        messages.push_back("message " + std::to_string(i));
+    const std::vector<std::string_view> views(messages.begin(), messages.end());
+    const auto signatures = signer.sign(views);
+    assert(signatures.size() == messages.size());
+    for (size_t i = 0; i < messages.size(); ++i)
+    {
+        assert(signatures[i] == signer.sign(messages[i]));
+        assert(verify_rs256(messages[i], signatures[i], public_key));
+    }
+
+    // the signer can be shared among threads..
+    std::vector<std::thread> threads;
+    std::vector<char> matches(4, false);
+    for (size_t t = 0; t < matches.size(); ++t)
+        threads.emplace_back([&, t]()
+                             { matches[t] = signer.sign(views) == signatures; });
+    for (auto &th : threads)
+        th.join();
+    for ([[maybe_unused]] char match : matches)
+        assert(match);
+
+    [[maybe_unused]] bool thrown = false;
+    try
+    {
+        utils::rs256_signer invalid("not a key");
+    }
+    catch (const std::runtime_error &)
+    {
+        thrown = true;
+    }
+    assert(thrown);
+    assert(utils::sign_rs256("data", "not a key").empty());
+}
+
+void test_rs256_verifier()
+{
+    const std::string key1 = generate_private_key(), key2 = generate_private_key();
+    const utils::rs256_signer signer1(key1), signer2(key2);
+
+    utils::rs256_verifier verifier;
+    verifier.add_key("k1", utils::extract_public_key(key1));
+    verifier.add_key("k2", utils::extract_public_key(key2));
+    assert(verifier.has_key("k1") && verifier.has_key("k2") && !verifier.has_key("k3"));
+
+    const std::string sig1 = signer1.sign("header.payload"), sig2 = signer2.sign("header.payload");
+    assert(verifier.verify("k1", "header.payload", sig1));
+    assert(verifier.verify("k2", "header.payload", sig2));
+    assert(!verifier.verify("k1", "header.payload", sig2)); // wrong key..
+    assert(!verifier.verify("k1", "header.payloaD", sig1)); // tampered data..
+    assert(!verifier.verify("k3", "header.payload", sig1)); // unknown key..
+    assert(!verifier.verify("k1", "header.payload", sig1.substr(1)));
+
+    std::vector<std::string> messages;
+    for (size_t i = 0; i < 30; ++i)
+        messages.push_back("message " + std::to_string(i));
+    std::vector<std::string> signatures;
+    std::vector<utils::rs256_token> tokens;
+    for (size_t i = 0; i < messages.size(); ++i)
+        signatures.push_back(i % 3 == 0 ? signer2.sign(messages[i]) : signer1.sign(messages[i]));
+    for (size_t i = 0; i < messages.size(); ++i) // every fifth token claims the wrong key..
+        tokens.push_back({(i % 3 == 0) != (i % 5 == 4) ? "k2" : "k1", messages[i], signatures[i]});
+    const auto valid = verifier.verify(tokens);
+    assert(valid.size() == tokens.size());
+    for (size_t i = 0; i < tokens.size(); ++i)
+        assert(valid[i] == (i % 5 != 4));
+
+    // the verifier can be shared among threads..
+    std::vector<std::thread> threads;
+    std::vector<char> matches(4, false);
+    for (size_t t = 0; t < matches.size(); ++t)
+        threads.emplace_back([&, t]()
+                             { matches[t] = verifier.verify(tokens) == valid; });
+    for (auto &th : threads)
+        th.join();
+    for ([[maybe_unused]] char match : matches)
+        assert(match);
+
+    // keys can be replaced and removed..
+    verifier.add_key("k1", utils::extract_public_key(key2));
+    assert(verifier.verify("k1", "header.payload", sig2));
+    [[maybe_unused]] const bool removed = verifier.remove_key("k1"), removed_twice = verifier.remove_key("k1"); // outside of the asserts, so that the key is removed also with NDEBUG..
+    assert(removed);
+    assert(!removed_twice);
+    assert(!verifier.verify("k1", "header.payload", sig2));
+
+    [[maybe_unused]] bool thrown = false;
+    try
+    {
+        verifier.add_key("bad", "not a key");
+    }
+    catch (const std::runtime_error &)
+    {
+        thrown = true;
+    }
+    assert(thrown);
+}
+
+void test_password_hasher()
+{
+    // PBKDF2-HMAC-SHA256 known-answer vector (password "password", salt "salt", one iteration)..
+    assert(utils::encode_password("password", "salt", 1) == "120fb6cffcf8b32c43e7225256c4f837a86548c92ccc35480805987cb70be17b");
+
+    const auto [salt, encoded] = utils::encode_password("secret");
+    assert(salt.size() == 32);
+    assert(utils::encode_password("secret", salt) == encoded);
+
+    std::atomic<size_t> callbacks = 0;
+    {
+        utils::password_hasher hasher(2, 1, 4); // a small queue, so that submissions wait for room..
+        assert(hasher.get_iterations() == 1);
+        assert(hasher.encode("password", "salt").get() == "120fb6cffcf8b32c43e7225256c4f837a86548c92ccc35480805987cb70be17b");
+
+        auto salted = hasher.encode("secret").get();
+        assert(utils::encode_password("secret", salted.first, 1) == salted.second);
+
+        std::vector<std::pair<std::string, std::string>> batch;
+        for (size_t i = 0; i < 50; ++i)
+            batch.emplace_back("password " + std::to_string(i), "salt " + std::to_string(i));
+        auto futures = hasher.encode(batch);
+        assert(futures.size() == batch.size());
+        for (size_t i = 0; i < batch.size(); ++i)
+            assert(futures[i].get() == utils::encode_password(batch[i].first, batch[i].second, 1));
+
+        for (size_t i = 0; i < 20; ++i)
+            hasher.encode("password", "salt", [&callbacks](std::string enc)
+                          { if (enc == "120fb6cffcf8b32c43e7225256c4f837a86548c92ccc35480805987cb70be17b") ++callbacks; });
+
+        // a throwing callback does not terminate the worker..
+        hasher.encode("password", "salt", [](std::string)
+                      { throw std::logic_error("callback failure"); });
+        hasher.encode("password", "salt", [&callbacks](std::string)
+                      { ++callbacks; });
+    } // the queued requests are completed before the workers stop..
+    assert(callbacks == 21);
+
+    // the iteration count is configurable..
+    utils::password_hasher slower(1, 2);
+    assert(slower.encode("password", "salt").get() == "ae4d0c95af6b46d32d0adff928f06dd02a303f8ef3c251dfd6e2d85a95474c43");
+}
+#endif
+
 int main()
 {
     test_sha1();
+    test_sha1_streaming();
+    test_sha1_backends();
+    test_sha1_batch();
+    test_base64();
+    test_base64_streaming();
+#ifdef UTILS_ENABLE_CRYPTO
+    test_rs256_signer();
+    test_rs256_verifier();
+    test_password_hasher();
+#endif
 
     return 0;
 }
@@ -0,0 +1,100 @@
+#include "logging.hpp"
+#include <cassert>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <string>
+
+// the number of lines each `LOG_INFO` and `LOG_WARN` produces at the configured logging level..
+constexpr size_t info_lines = LOGGING_LEVEL >= LOG_INFO_LEVEL ? 1 : 0;
+constexpr size_t warn_lines = LOGGING_LEVEL >= LOG_WARN_LEVEL ? 1 : 0;
+
+struct nested_log
+{
+    int value;
+};
+
+// logs while being formatted into another log line..
+std::ostream &operator<<(std::ostream &os, const nested_log &n)
+{
+    LOG_INFO("inner " << n.value);
+    return os << "outer " << n.value;
+}
+
+void test_logging()
+{
+#ifdef LOGGING_ASYNC
+    std::ostringstream sink;
+    utils::set_log_sink(sink);
+#endif
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+        threads.emplace_back([t]()
+                             { for (int i = 0; i < 1000; ++i)
+                                 LOG_INFO("thread " << t << " line " << i); });
+    for (auto &th : threads)
+        th.join();
+
+#ifdef LOGGING_ASYNC
+    utils::flush_log();
+    size_t lines = 0;
+    std::string line;
+    std::istringstream in(sink.str());
+    while (std::getline(in, line))
+        ++lines;
+    assert(utils::dropped_log_records() == 0);
+    assert(lines == 4000 * info_lines);
+
+    // a line logged while formatting another line does not corrupt it..
+    LOG_INFO("before " << nested_log{7} << " after");
+    utils::flush_log();
+    [[maybe_unused]] const auto nested_out = sink.str();
+    assert(!info_lines || (nested_out.find("before outer 7 after") != std::string::npos && nested_out.find("inner 7") != std::string::npos));
+
+    // records which do not fit the buffer are dropped and counted..
+    utils::set_log_overflow_policy(utils::log_overflow_policy::drop);
+    const std::string long_line(1 << 12, 'x');
+    for (int i = 0; i < 1000; ++i)
+        LOG_INFO(long_line);
+    utils::flush_log();
+    utils::set_log_sink(std::cerr);
+    size_t long_lines = 0;
+    in = std::istringstream(sink.str());
+    while (std::getline(in, line))
+        if (line.find(long_line) != std::string::npos)
+            ++long_lines;
+    assert(long_lines + utils::dropped_log_records() == 1000 * info_lines);
+#endif
+
+#ifdef LOGGING_BINARY
+    // binary records are formatted offline..
+    std::ostringstream binary_sink;
+    utils::set_log_overflow_policy(utils::log_overflow_policy::block);
+    utils::set_binary_log_sink(binary_sink);
+    for (int i = 0; i < 100; ++i)
+        LOG_WARN("value " << i << ' ' << (i % 2 == 0) << ' ' << 0.5 << ' ' << std::string("str") << ' ' << -i);
+    utils::flush_log();
+    utils::set_log_sink(std::cerr);
+
+    std::istringstream binary_in(binary_sink.str());
+    std::ostringstream decoded;
+    [[maybe_unused]] const bool well_formed = utils::decode_binary_log(binary_in, decoded);
+    assert(well_formed);
+    in = std::istringstream(decoded.str());
+    lines = 0;
+    while (std::getline(in, line))
+    {
+        assert(line.find("value " + std::to_string(lines) + ' ' + (lines % 2 == 0 ? '1' : '0') + " 0.5 str " + std::to_string(-static_cast<int>(lines))) != std::string::npos);
+        ++lines;
+    }
+    assert(lines == 100 * warn_lines);
+#endif
+}
+
+int main()
+{
+    test_logging();
+
+    return 0;
+}
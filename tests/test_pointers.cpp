@@ -1,6 +1,35 @@
 #include "memory.hpp"
 #include "logging.hpp"
 #include <vector>
+#include <thread>
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+
+static std::atomic<size_t> allocations = 0;
+
+void *operator new(std::size_t size)
+{
+    ++allocations;
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void *operator new(std::size_t size, std::align_val_t align)
+{
+    ++allocations;
+    const auto a = static_cast<std::size_t>(align);
+    if (void *p = std::aligned_alloc(a, (size + a - 1) / a * a))
+        return p;
+    throw std::bad_alloc();
+}
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
 
 class A
 {
@@ -35,6 +64,360 @@ void test_s_ptr()
     s_ptr_method(a);
 }
 
+struct counted
+{
+    static inline std::atomic<int> alive = 0;
+
+    counted() { ++alive; }
+    ~counted() { --alive; }
+
+    int value = 42;
+};
+
+void test_s_ptr_use_count()
+{
+    {
+        auto a = utils::make_s_ptr<counted>();
+        assert(a.use_count() == 1);
+        {
+            auto b = a;
+            assert(a.use_count() == 2);
+            utils::s_ptr<counted> c;
+            c = std::move(b);
+            assert(a.use_count() == 2 && !b);
+        }
+        assert(a.use_count() == 1);
+        assert(counted::alive == 1);
+    }
+    assert(counted::alive == 0);
+}
+
+void test_atomic_s_ptr()
+{
+    {
+        auto shared = utils::make_atomic_s_ptr<counted>();
+        std::vector<std::thread> threads;
+        std::atomic<int> sum = 0;
+        for (size_t t = 0; t < 4; ++t)
+            threads.emplace_back([shared, &sum]()
+                                 {
+                                     std::vector<utils::atomic_s_ptr<counted>> copies;
+                                     for (size_t i = 0; i < 10000; ++i)
+                                     {
+                                         copies.push_back(shared);
+                                         if (copies.size() > 16)
+                                             copies.clear();
+                                     }
+                                     sum += shared->value; });
+        for (auto &th : threads)
+            th.join();
+        assert(sum == 4 * 42);
+        assert(shared.use_count() == 1);
+        assert(counted::alive == 1);
+    }
+    assert(counted::alive == 0);
+
+    // the last reference can be released by any thread..
+    for (size_t i = 0; i < 100; ++i)
+    {
+        auto shared = utils::make_atomic_s_ptr<counted>();
+        std::thread th([copy = shared]() mutable
+                       { copy = utils::atomic_s_ptr<counted>(); });
+        shared = utils::atomic_s_ptr<counted>();
+        th.join();
+    }
+    assert(counted::alive == 0);
+}
+
+struct base
+{
+    int id = 1;
+};
+
+struct derived : base
+{
+    derived(bool fail = false)
+    {
+        if (fail)
+            throw std::runtime_error("construction failed");
+        ++counted::alive;
+    }
+    ~derived() { --counted::alive; } // not reached through a virtual destructor..
+};
+
+void test_s_ptr_single_allocation()
+{
+    [[maybe_unused]] size_t before = allocations;
+    {
+        auto a = utils::make_s_ptr<counted>();
+        assert(allocations == before + 1); // the object and its control block..
+        assert(a->value == 42 && a.use_count() == 1);
+    }
+    assert(counted::alive == 0);
+
+    before = allocations;
+    {
+        utils::s_ptr<counted> a(new counted());
+        assert(allocations == before + 2); // the raw pointer constructor still works, with a separate control block..
+        auto b = a;
+        assert(b.use_count() == 2);
+    }
+    assert(counted::alive == 0);
+
+    {
+        utils::s_ptr<base> b = utils::make_s_ptr<derived>();
+        assert(counted::alive == 1 && b->id == 1);
+        utils::atomic_s_ptr<base> c = utils::make_atomic_s_ptr<derived>();
+        assert(counted::alive == 2);
+    } // the objects are destroyed as derived, through their control blocks..
+    assert(counted::alive == 0);
+
+    [[maybe_unused]] bool thrown = false;
+    try
+    {
+        auto d = utils::make_s_ptr<derived>(true);
+    }
+    catch (const std::runtime_error &)
+    {
+        thrown = true;
+    }
+    assert(thrown && counted::alive == 0);
+}
+
+struct node
+{
+    node() { ++counted::alive; }
+    ~node() { --counted::alive; }
+
+    utils::s_ptr<node> next;
+    utils::w_ptr<node> prev; // the back reference does not keep the previous node alive..
+};
+
+void test_w_ptr()
+{
+    utils::w_ptr<counted> w;
+    assert(w.expired() && !w.lock());
+
+    [[maybe_unused]] size_t before = allocations;
+    {
+        auto a = utils::make_s_ptr<counted>();
+        w = a;
+        auto w2 = w;
+        assert(allocations == before + 1); // weak pointers share the control block..
+        assert(!w.expired() && w.use_count() == 1);
+        auto b = w2.lock();
+        assert(b && b.get() == a.get() && a.use_count() == 2);
+    }
+    assert(counted::alive == 0); // the object is destroyed with the last shared pointer..
+    assert(w.expired() && !w.lock());
+    w.reset();
+    assert(w.use_count() == 0);
+
+    { // a doubly linked list is reclaimed, since the back references are weak..
+        auto head = utils::make_s_ptr<node>();
+        auto tail = utils::make_s_ptr<node>();
+        head->next = tail;
+        tail->prev = head;
+        assert(tail->prev.lock().get() == head.get());
+        assert(head.use_count() == 1 && tail.use_count() == 2);
+    }
+    assert(counted::alive == 0);
+
+    { // objects adopted through the raw pointer constructor..
+        utils::s_ptr<counted> a(new counted());
+        utils::w_ptr<counted> wa = a;
+        a = utils::s_ptr<counted>();
+        assert(counted::alive == 0 && wa.expired());
+    }
+
+    { // weak pointers locked concurrently with the release of the last shared pointer..
+        for (size_t i = 0; i < 100; ++i)
+        {
+            auto shared = utils::make_atomic_s_ptr<counted>();
+            utils::atomic_w_ptr<counted> weak = shared;
+            std::thread th([weak]()
+                           {
+                               for (size_t j = 0; j < 100; ++j)
+                                   if (auto locked = weak.lock())
+                                       assert(locked->value == 42); });
+            shared = utils::atomic_s_ptr<counted>();
+            th.join();
+            assert(weak.expired());
+        }
+        assert(counted::alive == 0);
+    }
+}
+
+struct tree_node : utils::ref_counted<tree_node>
+{
+    tree_node(int value) : value(value) { ++counted::alive; }
+    virtual ~tree_node() { --counted::alive; }
+
+    int value;
+    utils::i_ptr<tree_node> left, right;
+};
+
+struct leaf : tree_node
+{
+    leaf() : tree_node(0) {}
+};
+
+struct shared_node : utils::ref_counted<shared_node, utils::atomic_rc>
+{
+    int value = 42;
+};
+
+void test_i_ptr()
+{
+    static_assert(sizeof(utils::i_ptr<tree_node>) == sizeof(tree_node *));
+
+    [[maybe_unused]] size_t before = allocations;
+    {
+        auto root = utils::make_i_ptr<tree_node>(1);
+        assert(allocations == before + 1 && root.use_count() == 1);
+        root->left = utils::make_i_ptr<tree_node>(2);
+        root->right = utils::make_i_ptr<leaf>();
+        assert(counted::alive == 3);
+
+        utils::i_ptr<tree_node> raw(root->left.get()); // rebuilt from the raw pointer, sharing the same count..
+        assert(raw.use_count() == 2 && raw == root->left);
+        auto copy = root;
+        assert(root.use_count() == 2);
+        copy = std::move(raw);
+        assert(!raw && root.use_count() == 1 && copy.use_count() == 2);
+        copy.reset();
+        assert(root->left.use_count() == 1);
+    }
+    assert(counted::alive == 0); // the whole tree is released, leaves included..
+
+    auto shared = utils::make_i_ptr<shared_node>();
+    [[maybe_unused]] shared_node clone = *shared; // copies do not share the reference count..
+    assert(clone.use_count() == 0 && clone.value == 42);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < 4; ++t)
+        threads.emplace_back([shared]()
+                             {
+                                 for (size_t i = 0; i < 10000; ++i)
+                                 {
+                                     utils::i_ptr<shared_node> copy = shared;
+                                     assert(copy->value == 42);
+                                 } });
+    for (auto &th : threads)
+        th.join();
+    assert(shared.use_count() == 1);
+}
+
+struct point
+{
+    point(int x, int y) : x(x), y(y) { ++counted::alive; }
+    ~point() { --counted::alive; }
+
+    int x, y;
+};
+
+struct alignas(64) wide
+{
+    unsigned char bytes[64];
+};
+
+struct final_delete final
+{
+    void operator()(point *ptr) const noexcept { delete ptr; }
+};
+
+void delete_point(point *ptr) noexcept { delete ptr; }
+
+void test_allocators()
+{
+    static_assert(sizeof(utils::u_ptr<point>) == sizeof(point *));
+    static_assert(sizeof(utils::u_ptr<point, utils::arena_delete<point>>) == sizeof(point *));
+
+    { // function pointers and final classes are stored as members..
+        utils::u_ptr<point, void (*)(point *)> p(new point(1, 2), delete_point);
+        utils::u_ptr<point, final_delete> q(new point(3, 4));
+        auto r = std::move(p);
+        assert(!p && r->x == 1 && q->y == 4 && counted::alive == 2);
+        assert(r.get_deleter() == delete_point);
+    }
+    assert(counted::alive == 0);
+
+    { // released slots are reused without touching the global allocator..
+        utils::object_pool<point> pool(4);
+        [[maybe_unused]] size_t before = allocations;
+        std::vector<utils::u_ptr<point, utils::pool_delete<point>>> points;
+        for (int i = 0; i < 10; ++i)
+            points.push_back(utils::make_u_ptr<point>(pool, i, -i));
+        assert(pool.size() == 10 && counted::alive == 10);
+        assert(points[7]->x == 7 && points[7]->y == -7);
+        points.clear();
+        assert(pool.size() == 0 && counted::alive == 0);
+        [[maybe_unused]] size_t after = allocations;
+        for (int i = 0; i < 10; ++i)
+            points.push_back(utils::make_u_ptr<point>(pool, i, i));
+        assert(allocations == after); // the chunks (and the vector) are reused..
+        assert(after - before <= 3 + 5);
+        points.clear();
+    }
+
+    { // over-aligned objects get aligned slots..
+        utils::object_pool<wide> pool(3);
+        std::vector<wide *> objects;
+        for (size_t i = 0; i < 10; ++i)
+            objects.push_back(pool.create());
+        for ([[maybe_unused]] const auto w : objects)
+            assert(reinterpret_cast<std::uintptr_t>(w) % alignof(wide) == 0);
+        for (const auto w : objects)
+            pool.destroy(w);
+    }
+
+    { // an arena is reclaimed at once..
+        utils::arena a(1024);
+        [[maybe_unused]] size_t before = allocations;
+        {
+            auto p = utils::make_u_ptr<point>(a, 1, 2);
+            auto q = utils::make_u_ptr<point>(a, 3, 4);
+            assert(p->x == 1 && q->y == 4 && counted::alive == 2);
+            [[maybe_unused]] void *aligned = a.allocate(sizeof(wide), alignof(wide)), *large = a.allocate(4096); // outside of the asserts, as the allocations are counted below..
+            assert(reinterpret_cast<std::uintptr_t>(aligned) % 64 == 0);
+            assert(large != nullptr); // a dedicated chunk..
+        }
+        assert(counted::alive == 0 && allocations == before + 2);
+        a.reset();
+        for (size_t i = 0; i < 16; ++i)
+            (void)a.allocate(32);
+        assert(allocations == before + 2); // the current chunk is reused..
+    }
+
+    { // shared pointers from pools and arenas, with weak references..
+        utils::s_ptr_pool<point> pool;
+        utils::w_ptr<point> w;
+        {
+            auto p = utils::make_s_ptr<point>(pool, 5, 6);
+            w = p;
+            auto q = p;
+            assert(pool.size() == 1 && q->x == 5 && q.use_count() == 2);
+        }
+        assert(counted::alive == 0 && pool.size() == 1 && w.expired()); // the weak pointer keeps the block..
+        w.reset();
+        assert(pool.size() == 0);
+
+        utils::s_ptr_pool<point, utils::atomic_rc> atomic_pool;
+        {
+            utils::atomic_s_ptr<point> p = utils::make_s_ptr<point>(atomic_pool, 7, 8);
+            assert(atomic_pool.size() == 1 && p->y == 8);
+        }
+        assert(atomic_pool.size() == 0);
+
+        utils::arena a;
+        {
+            auto p = utils::make_s_ptr<point>(a, 9, 10);
+            utils::s_ptr<point> q = p;
+            assert(counted::alive == 1 && q->x == 9);
+        }
+        assert(counted::alive == 0);
+    }
+}
+
 void test_ref_wrapper()
 {
     A a;
@@ -52,6 +435,12 @@ int main()
 {
     test_u_ptr();
     test_s_ptr();
+    test_s_ptr_use_count();
+    test_atomic_s_ptr();
+    test_s_ptr_single_allocation();
+    test_w_ptr();
+    test_i_ptr();
+    test_allocators();
     test_ref_wrapper();
     return 0;
 }
\ No newline at end of file
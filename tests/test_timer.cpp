@@ -0,0 +1,110 @@
+#include "timer.hpp"
+#include <cassert>
+#include <atomic>
+
+void test_timer()
+{
+    std::atomic<int> ticks{0};
+    utils::timer t(5, [&ticks]()
+                   { ++ticks; });
+    t.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    t.stop();
+    [[maybe_unused]] const int c_ticks = ticks.load();
+    assert(c_ticks > 1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    assert(ticks.load() == c_ticks);
+
+    // stopping waits for a running callback, which can still query its own timer..
+    std::atomic<bool> in_callback{false};
+    utils::timer *self = nullptr;
+    utils::timer querying(5, [&in_callback, &self]()
+                          {
+                              in_callback = true;
+                              std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                              (void)self->get_stats(); });
+    self = &querying;
+    querying.start();
+    while (!in_callback)
+        std::this_thread::yield();
+    querying.stop();
+}
+
+void test_timer_wheel()
+{
+    utils::timer_wheel wheel;
+    std::atomic<int> one_shot{0}, periodic{0}, cancelled{0}, far{0};
+
+    [[maybe_unused]] auto id0 = wheel.schedule(10, [&one_shot]()
+                                               { ++one_shot; });
+    auto id1 = wheel.schedule(0, [&periodic]()
+                              { ++periodic; }, 2);
+    auto id2 = wheel.schedule(20, [&cancelled]()
+                              { ++cancelled; });
+    auto id3 = wheel.schedule(300, [&far]() // beyond the first level of the wheel..
+                              { ++far; });
+    assert(wheel.size() == 4);
+    [[maybe_unused]] const bool cancelled_once = wheel.cancel(id2), cancelled_twice = wheel.cancel(id2); // outside of the asserts, so that the timer is cancelled also with NDEBUG..
+    assert(cancelled_once);
+    assert(!cancelled_twice);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(400));
+    assert(one_shot.load() == 1);
+    assert(periodic.load() > 1);
+    assert(cancelled.load() == 0);
+    assert(far.load() == 1);
+    [[maybe_unused]] const bool far_cancelled = wheel.cancel(id3), periodic_cancelled = wheel.cancel(id1);
+    assert(!far_cancelled);
+    assert(periodic_cancelled);
+    assert(wheel.size() == 0);
+
+    // many timers share the same thread..
+    std::atomic<int> count{0};
+    for (size_t i = 0; i < 1000; ++i)
+        [[maybe_unused]] auto id = wheel.schedule(i % 50, [&count]()
+                                                  { ++count; });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    assert(count.load() == 1000);
+}
+
+void test_timer_overrun()
+{
+    utils::timer_wheel wheel;
+    utils::timer skipping(wheel, 10, []()
+                          { std::this_thread::sleep_for(std::chrono::milliseconds(25)); }, utils::overrun_policy::skip);
+    skipping.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    auto stats = skipping.get_stats();
+    skipping.stop();
+
+    assert(stats.ticks > 1);
+    assert(stats.ticks < 20);
+    assert(stats.overruns > 0);
+    assert(stats.missed_ticks > 0);
+    assert(stats.max_duration >= std::chrono::milliseconds(25));
+    size_t histogram_count = 0;
+    for (const auto &c : stats.duration_histogram)
+        histogram_count += c;
+    assert(histogram_count == stats.ticks);
+    assert(stats.duration_histogram[utils::timer_stats::histogram_size - 1] == stats.ticks); // all the callbacks last more than 2^15 microseconds..
+
+    utils::timer catching_up(wheel, 10, []()
+                             { std::this_thread::sleep_for(std::chrono::milliseconds(15)); });
+    catching_up.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    stats = catching_up.get_stats();
+    catching_up.stop();
+
+    assert(stats.overruns > 0);
+    assert(stats.missed_ticks == 0);
+    assert(stats.max_jitter >= stats.mean_jitter());
+}
+
+int main()
+{
+    test_timer();
+    test_timer_wheel();
+    test_timer_overrun();
+
+    return 0;
+}
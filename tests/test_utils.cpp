@@ -1,11 +1,26 @@
 #include <cassert>
+#include <array>
+#include <numeric>
+#include <random>
+#include <limits>
+#include <stdexcept>
 #include "rational.hpp"
 #include "inf_rational.hpp"
 #include "lit.hpp"
+#include "bool.hpp"
+#include "watches.hpp"
+#include "clause.hpp"
 #include "lin.hpp"
 #include "tableau.hpp"
 #include "loss.hpp"
 #include "matrix.hpp"
+#include "combinations.hpp"
+#include "cartesian_product.hpp"
+#include "instrumentation.hpp"
+#ifdef UTILS_ENABLE_INSTRUMENTATION
+#include <sstream>
+#include <thread>
+#endif
 
 void test_literals()
 {
@@ -21,6 +36,173 @@ void test_literals()
     assert(sign(l2) == true);
 }
 
+void test_lbool_vector()
+{
+    utils::lbool_vector vals(100);
+    assert(vals.size() == 100 && vals.count_undefined() == 100);
+    assert(vals.count(utils::False) == 0 && vals.count(utils::True) == 0);
+
+    vals.assign(utils::lit(3));
+    vals.assign(utils::lit(40, false));
+    vals.set(99, utils::True);
+    assert(vals.value(3) == utils::True && vals.value(40) == utils::False);
+    assert(vals.value(utils::lit(3)) == utils::True && vals.value(!utils::lit(3)) == utils::False);
+    assert(vals.value(utils::lit(40)) == utils::False && vals.value(!utils::lit(40)) == utils::True);
+    assert(vals.value(utils::lit(5)) == utils::Undefined && vals.value(!utils::lit(5)) == utils::Undefined);
+    assert(vals.count_undefined() == 97 && vals.count(utils::True) == 2 && vals.count(utils::False) == 1);
+
+    assert(vals.find_next_undefined() == 0);
+    assert(vals.find_next_undefined(3) == 4);
+    assert(vals.find_next(utils::True, 4) == 99);
+    assert(vals.find_next(utils::False) == 40);
+
+    vals.fill(utils::True);
+    vals.unassign(70);
+    assert(vals.find_next_undefined() == 70 && vals.find_next_undefined(71) == 100);
+    assert(vals.count(utils::True) == 99);
+
+    vals.resize(33);
+    assert(vals.count(utils::True) == 33 && vals.find_next(utils::False) == 33);
+    [[maybe_unused]] const utils::var pushed = vals.push_back(utils::False);
+    assert(pushed == 33 && vals.count(utils::False) == 1 && vals[33] == utils::False);
+    vals.resize(200, utils::Undefined);
+    assert(vals.count_undefined() == 166 && vals.find_next_undefined() == 34);
+}
+
+void test_lit_map()
+{
+    utils::lit_map<int> m(3);
+    assert(m.vars() == 3);
+    m[utils::lit(1)] = 1;
+    m[!utils::lit(1)] = -1;
+    assert(m[utils::lit(1)] == 1 && m[!utils::lit(1)] == -1 && m[utils::lit(0)] == 0);
+    [[maybe_unused]] const utils::var v = m.add_var();
+    assert(v == 3);
+    m[!utils::lit(3)] = 7;
+    assert(m.vars() == 4 && m[!utils::lit(3)] == 7 && m[utils::lit(1)] == 1);
+}
+
+/**
+ * @brief Propagates the trail, from `head`, through the two-watched-literal scheme, returning false on a conflict.
+ */
+bool propagate(std::vector<std::vector<utils::lit>> &clauses, utils::watch_lists<size_t> &watches, utils::lbool_vector &values, std::vector<utils::lit> &trail, size_t head = 0)
+{
+    while (head < trail.size())
+    {
+        const utils::lit q = trail[head++];
+        if (!watches.propagate(q, values, [&](utils::watcher<size_t> &w)
+                               {
+                                   auto &c = clauses[w.clause];
+                                   if (c[0] == !q) // the false literal goes second..
+                                       std::swap(c[0], c[1]);
+                                   if (values.value(c[0]) == utils::True)
+                                   {
+                                       w.blocker = c[0];
+                                       return utils::watch_action::keep;
+                                   }
+                                   for (size_t k = 2; k < c.size(); ++k)
+                                       if (values.value(c[k]) != utils::False)
+                                       { // we watch another literal..
+                                           std::swap(c[1], c[k]);
+                                           watches.watch(c[1], w.clause, c[0]);
+                                           return utils::watch_action::remove;
+                                       }
+                                   if (values.value(c[0]) == utils::False)
+                                       return utils::watch_action::stop;
+                                   values.assign(c[0]);
+                                   trail.push_back(c[0]);
+                                   return utils::watch_action::keep; }))
+            return false;
+    }
+    return true;
+}
+
+void test_watch_lists()
+{
+    const utils::lit a(0), b(1), c(2), d(3);
+    std::vector<std::vector<utils::lit>> clauses = {{!a, b}, {!b, c}, {!c, !a, d}, {!d, b, c}};
+    utils::watch_lists<size_t> watches(4);
+    for (size_t i = 0; i < clauses.size(); ++i)
+    {
+        watches.watch(clauses[i][0], i, clauses[i][1]);
+        watches.watch(clauses[i][1], i, clauses[i][0]);
+    }
+    assert(watches[a].size() == 2 && watches[b].size() == 1 && watches[!b].size() == 2);
+
+    utils::lbool_vector values(4);
+    std::vector<utils::lit> trail{a};
+    values.assign(a);
+    [[maybe_unused]] const bool consistent = propagate(clauses, watches, values, trail);
+    assert(consistent);
+    assert(trail.size() == 4 && values.value(b) == utils::True && values.value(c) == utils::True && values.value(d) == utils::True);
+    size_t n_watches = 0;
+    for (size_t v = 0; v < 4; ++v)
+        n_watches += watches[utils::lit(v)].size() + watches[!utils::lit(v)].size();
+    assert(n_watches == 2 * clauses.size()); // watches move, but are never lost..
+
+    // a conflict stops the propagation, keeping all the watches..
+    clauses.push_back({!b, !c});
+    watches.watch(clauses[4][0], 4, clauses[4][1]);
+    watches.watch(clauses[4][1], 4, clauses[4][0]);
+    utils::lbool_vector fresh(4);
+    trail = {a};
+    fresh.assign(a);
+    [[maybe_unused]] const bool conflict = !propagate(clauses, watches, fresh, trail);
+    assert(conflict);
+    [[maybe_unused]] const bool unwatched = watches.unwatch(clauses[4][0], 4), unwatched_twice = watches.unwatch(clauses[4][0], 4);
+    assert(unwatched && !unwatched_twice);
+}
+
+void test_clause_arena()
+{
+    const utils::lit a(0), b(1), c(2), d(3);
+    utils::clause_arena db;
+    utils::watch_lists<utils::clause_ref> watches(4);
+    std::vector<utils::clause_ref> refs;
+    for (const auto &lits : std::vector<std::vector<utils::lit>>{{!a, b}, {!b, c, d}, {!c, !a, d}, {a, b, c, d}})
+    {
+        const auto r = db.alloc(lits);
+        watches.watch(lits[0], r, lits[1]);
+        watches.watch(lits[1], r, lits[0]);
+        refs.push_back(r);
+    }
+    const auto learnt = db.alloc({!d, b}, true);
+    db[learnt].set_lbd(2);
+    db[learnt].set_activity(1.5f);
+    watches.watch(!d, learnt, b);
+    watches.watch(b, learnt, !d);
+    refs.push_back(learnt);
+
+    assert(db[refs[1]].size() == 3 && db[refs[1]][2] == d && !db[refs[1]].learnt());
+    assert(db[learnt].learnt() && db[learnt].lbd() == 2 && db[learnt].activity() == 1.5f);
+    assert(sizeof(utils::clause_ref) == 4 && sizeof(utils::watcher<utils::clause_ref>) == 2 * sizeof(utils::lit)); // the blocker pads each watch to two words..
+
+    [[maybe_unused]] const size_t before = db.size();
+    utils::clause_ref reason = refs[2];
+    db.free(refs[0]);
+    db.free(refs[3]);
+    db.free(refs[3]);
+    assert(db.wasted() > 0 && db.wasted() < before);
+
+    db.garbage_collect(watches, refs, [&reason](auto &&relocate)
+                       { relocate(reason); });
+    assert(db.wasted() == 0 && db.size() < before);
+    assert(refs.size() == 3);
+    assert(db[reason].size() == 3 && db[reason][0] == !c && db[reason][2] == d);
+    assert(db[refs[2]].learnt() && db[refs[2]].lbd() == 2 && db[refs[2]].activity() == 1.5f && db[refs[2]][0] == !d);
+
+    size_t n_watches = 0;
+    for (size_t v = 0; v < 4; ++v)
+        for (const auto &l : {utils::lit(v), !utils::lit(v)})
+            for (const auto &w : watches[l])
+            {
+                ++n_watches;
+                [[maybe_unused]] const auto &cl = db[w.clause];
+                assert(!cl.removed() && (cl[0] == !l || cl[1] == !l)); // the watches still point to their clauses..
+            }
+    assert(n_watches == 2 * refs.size());
+}
+
 void test_rationals()
 {
     utils::rational r1(1, 2);
@@ -143,6 +325,188 @@ void test_rationals_2()
     assert(ceil(r4) == -2);
 }
 
+constexpr utils::rational harmonic(INT_TYPE n) noexcept
+{
+    utils::rational h;
+    for (INT_TYPE i = 1; i <= n; ++i)
+        h += utils::rational(1, i);
+    return h;
+}
+
+void test_rationals_constexpr()
+{
+    // the arithmetic is evaluated at compile time..
+    static_assert(utils::rational(2, 4) == utils::rational(1, 2));
+    static_assert(utils::rational(1, -2).numerator() == -1 && utils::rational(1, -2).denominator() == 2);
+    static_assert(utils::rational(1, 2) + 1 == utils::rational(3, 2));
+    static_assert(utils::rational(1, 2) + utils::rational(1, 3) == utils::rational(5, 6));
+    static_assert(utils::rational(2, 3) * utils::rational(3, 4) == utils::rational(1, 2));
+    static_assert(utils::rational(1, 2) / utils::rational(-1, 4) == -2);
+    static_assert(utils::rational::one / utils::rational(3) < utils::rational(1, 2));
+    static_assert(is_positive_infinite(utils::rational(5) * utils::rational::positive_infinite));
+    static_assert(floor(utils::rational(-7, 3)) == -3 && ceil(utils::rational(-7, 3)) == -2);
+
+    // compile-time tables..
+    constexpr std::array<utils::rational, 4> h{harmonic(1), harmonic(2), harmonic(3), harmonic(4)};
+    static_assert(h[3] == utils::rational(25, 12));
+    assert(to_string(h[2]) == "11/6");
+}
+
+// a copy of the previous, Euclidean, arithmetic of the rationals, against which the binary gcd and its shortcuts are checked..
+struct reference_rational
+{
+    INT_TYPE num, den;
+};
+
+reference_rational reference_normalize(INT_TYPE num, INT_TYPE den)
+{
+    if (den != 1)
+    {
+        INT_TYPE c_gcd = std::gcd(num, den);
+        num /= c_gcd;
+        den /= c_gcd;
+        if (den < 0)
+        {
+            den = -den;
+            num = -num;
+        }
+    }
+    return {num, den};
+}
+
+reference_rational reference_add(const reference_rational &lhs, const reference_rational &rhs)
+{
+    if (lhs.num == 0)
+        return rhs;
+    if (rhs.num == 0)
+        return lhs;
+    if (lhs.den == 1 && rhs.den == 1)
+        return {lhs.num + rhs.num, 1};
+
+    INT_TYPE f = std::gcd(lhs.num, rhs.num);
+    INT_TYPE g = std::gcd(lhs.den, rhs.den);
+
+    reference_rational res = reference_normalize((lhs.num / f) * (rhs.den / g) + (rhs.num / f) * (lhs.den / g), std::lcm(lhs.den, rhs.den));
+    res.num *= f;
+    return res;
+}
+
+reference_rational reference_mul(const reference_rational &lhs, const reference_rational &rhs)
+{
+    reference_rational c = reference_normalize(lhs.num, rhs.den);
+    reference_rational d = reference_normalize(rhs.num, lhs.den);
+    return reference_normalize(c.num * d.num, c.den * d.den);
+}
+
+bool same(const utils::rational &r, const reference_rational &ref) { return r.numerator() == ref.num && r.denominator() == ref.den; }
+
+void test_rationals_differential()
+{
+    std::mt19937_64 gen(42);
+    constexpr int digits = std::numeric_limits<INT_TYPE>::digits; // the value bits of `INT_TYPE`, which may be as narrow as an `int`..
+
+    // the binary gcd agrees with the Euclidean one, also on zeros, signs and powers of two..
+    for (int i = 0; i < 100000; ++i)
+    {
+        const auto pick = [&gen]() -> INT_TYPE
+        { // values in `[-2^(digits-2), 2^(digits-2)]`..
+            switch (gen() % 4)
+            {
+            case 0:
+                return 0;
+            case 1:
+                return INT_TYPE(1) << (gen() % (digits - 1));
+            default:
+                return static_cast<INT_TYPE>(gen() >> (65 - digits)) - (INT_TYPE(1) << (digits - 2));
+            }
+        };
+        // the multiplier shares factors between the operands, while the division keeps the product within range..
+        [[maybe_unused]] const INT_TYPE a = pick(), b = pick() / 1024 * static_cast<INT_TYPE>(gen() % 3 ? 1 : gen() % 1000 + 1);
+        assert(utils::binary_gcd(a, b) == std::gcd(a, b));
+    }
+
+    // the denominators are often equal, powers of two or sharing factors, so as to exercise all the shortcuts..
+    const auto random_rational = [&gen](INT_TYPE other_den) -> std::pair<utils::rational, reference_rational>
+    {
+        const INT_TYPE num = static_cast<INT_TYPE>(gen() % 2001) - 1000;
+        INT_TYPE den = 1;
+        switch (gen() % 5)
+        {
+        case 0:
+            den = other_den;
+            break;
+        case 1:
+            den = INT_TYPE(1) << (gen() % 11);
+            break;
+        case 2:
+            den = other_den * static_cast<INT_TYPE>(gen() % 6 + 1);
+            break;
+        default:
+            den = static_cast<INT_TYPE>(gen() % 1000) + 1;
+        }
+        if (gen() % 2)
+            den = -den;
+        return {utils::rational(num, den), reference_normalize(num, den)};
+    };
+
+    for (int i = 0; i < 100000; ++i)
+    {
+        const auto [a, ref_a] = random_rational(static_cast<INT_TYPE>(gen() % 100) + 1);
+        const auto [b, ref_b] = random_rational(ref_a.den);
+        assert(same(a, ref_a) && same(b, ref_b));
+
+        assert(same(a + b, reference_add(ref_a, ref_b)));
+        assert(same(a - b, reference_add(ref_a, {-ref_b.num, ref_b.den})));
+        assert(same(a * b, reference_mul(ref_a, ref_b)));
+        if (!is_zero(b))
+            assert(same(a / b, reference_mul(ref_a, reference_normalize(ref_b.den, ref_b.num))));
+        const INT_TYPE k = static_cast<INT_TYPE>(gen() % 41) - 20;
+        assert(same(a * k, reference_mul(ref_a, {k, 1})));
+        assert(same(a + k, reference_add(ref_a, {k, 1})));
+
+        utils::rational c = a;
+        c += b;
+        assert(same(c, reference_add(ref_a, ref_b)));
+        c = a;
+        c -= b;
+        assert(same(c, reference_add(ref_a, {-ref_b.num, ref_b.den})));
+        c = a;
+        c *= b;
+        assert(same(c, reference_mul(ref_a, ref_b)));
+        c = a;
+        c *= k;
+        assert(same(c, reference_mul(ref_a, {k, 1})));
+        c = a;
+        c += c; // aliasing..
+        assert(same(c, reference_add(ref_a, ref_a)));
+        c *= c;
+        assert(same(c, reference_mul(reference_add(ref_a, ref_a), reference_add(ref_a, ref_a))));
+
+        assert((a < b) == (ref_a.num * ref_b.den < ref_b.num * ref_a.den));
+        assert((a == b) == (ref_a.num * ref_b.den == ref_b.num * ref_a.den));
+    }
+
+    // longer chains keep the results in canonical form..
+    for (int i = 0; i < 1000; ++i)
+    {
+        utils::rational sum, prod(1);
+        reference_rational ref_sum{0, 1}, ref_prod{1, 1};
+        for (int j = 0; j < 20; ++j)
+        {
+            const INT_TYPE num = static_cast<INT_TYPE>(gen() % 7) - 3, den = static_cast<INT_TYPE>(gen() % 16) + 1;
+            sum += utils::rational(num, den);
+            ref_sum = reference_add(ref_sum, reference_normalize(num, den));
+            if (num != 0 && j < (digits > 32 ? 8 : 4)) // the product of the denominators stays within range..
+            {
+                prod *= utils::rational(num, den);
+                ref_prod = reference_mul(ref_prod, reference_normalize(num, den));
+            }
+        }
+        assert(same(sum, ref_sum));
+        assert(same(prod, ref_prod));
+    }
+}
+
 void test_inf_rationals()
 {
     assert(utils::rational::negative_infinite < utils::rational::positive_infinite);
@@ -273,6 +637,70 @@ void test_tableau()
     t.pivot(x0, x1);
 }
 
+void test_instrumentation()
+{
+    // the macros are statements, whether or not the instrumentation is enabled..
+    for (int i = 0; i < 3; ++i)
+        UTILS_COUNT("test.loop");
+    if (true)
+        UTILS_RECORD("test.values", 4);
+    else
+        UTILS_COUNT_N("test.loop", 2);
+
+#ifdef UTILS_ENABLE_INSTRUMENTATION
+    utils::reset_metrics();
+    auto worker = []()
+    {
+        for (int i = 0; i < 1000; ++i)
+            UTILS_COUNT("test.loop");
+        UTILS_COUNT_N("test.loop", 500);
+        for (std::uint64_t v = 0; v < 8; ++v)
+            UTILS_RECORD("test.values", v);
+    };
+    std::thread th0(worker), th1(worker);
+    th0.join();
+    th1.join(); // the values of the terminated threads are retained..
+
+    auto metrics = utils::get_metrics();
+    assert(metrics.counters.at("test.loop") == 3000);
+    [[maybe_unused]] const auto &values = metrics.histograms.at("test.values");
+    assert(values.count == 16);
+    assert(values.sum == 56);
+    assert(values.min == 0 && values.max == 7);
+    assert(values.buckets[0] == 2 && values.buckets[1] == 2 && values.buckets[2] == 4 && values.buckets[3] == 8);
+
+    // the instrumented subsystems report through the same counters..
+    utils::start_tracing();
+    test_tableau();
+    utils::stop_tracing();
+    metrics = utils::get_metrics();
+    assert(metrics.counters.at("tableau.pivots") == 1);
+    assert(metrics.counters.at("rational.gcd") > 0);
+    assert(metrics.histograms.at("tableau.pivot").count == 1);
+    assert(metrics.histograms.at("tableau.pivot_rows").max == 1);
+
+    std::ostringstream json;
+    utils::write_metrics_json(json);
+    assert(json.str().find("\"tableau.pivots\": 1") != std::string::npos);
+
+    std::ostringstream trace;
+    utils::write_chrome_trace(trace);
+    assert(trace.str().find("\"name\": \"tableau.pivot\", \"ph\": \"X\"") != std::string::npos);
+
+    // outside of the tracing window, timers are only aggregated..
+    test_tableau();
+    std::ostringstream trace_1;
+    utils::write_chrome_trace(trace_1);
+    assert(trace_1.str() == trace.str());
+    assert(utils::get_metrics().histograms.at("tableau.pivot").count == 2);
+
+    utils::reset_metrics();
+    metrics = utils::get_metrics();
+    assert(metrics.counters.at("test.loop") == 0);
+    assert(metrics.histograms.count("test.values") == 0);
+#endif
+}
+
 void test_matrix()
 {
     utils::matrix<2, 3, int> m1 = {{{1, 2, 3}, {4, 5, 6}}};
@@ -294,13 +722,90 @@ void test_loss()
     assert(utils::mae(y_true.data(), y_pred.data(), 3) == 0);
 }
 
+void test_combinations()
+{
+    std::vector<int> v{0, 1, 2, 3, 4, 5};
+    auto combs = utils::combinations(v, 3);
+    assert(combs.size() == utils::combinations_count(v.size(), 3));
+    for (std::size_t r = 0; r < combs.size(); ++r)
+    {
+        auto c = utils::unrank_combination(v.size(), 3, r);
+        assert(std::vector<int>(c.cbegin(), c.cend()) == combs[r]);
+        assert(utils::rank_combination(c, v.size()) == r);
+    }
+
+    std::vector<std::vector<int>> parts;
+    for (std::size_t p = 0; p < 4; ++p)
+    {
+        auto [first, last] = utils::partition_range(combs.size(), 4, p);
+        auto c_part = utils::combinations(v, 3, first, last);
+        assert(c_part.size() == last - first);
+        parts.insert(parts.end(), c_part.cbegin(), c_part.cend());
+    }
+    assert(parts == combs);
+
+    // large counts do not overflow in the intermediate products..
+    if constexpr (sizeof(std::size_t) == 8)
+    {
+        assert(utils::combinations_count(64, 32) == 1832624140942590534ull);
+        assert(utils::combinations_count(67, 33) == 14226520737620288370ull);
+        const auto total = utils::combinations_count(64, 32);
+        [[maybe_unused]] const auto last = utils::unrank_combination(64, 32, total - 1);
+        assert(last.front() == 32 && last.back() == 63);
+        assert(utils::rank_combination(last, 64) == total - 1);
+        [[maybe_unused]] const auto middle = utils::unrank_combination(64, 32, total / 2);
+        assert(utils::rank_combination(middle, 64) == total / 2);
+
+        // ..while the counts which do not fit are reported..
+        [[maybe_unused]] bool thrown = false;
+        try
+        {
+            [[maybe_unused]] const auto c = utils::combinations_count(68, 34);
+        }
+        catch (const std::overflow_error &)
+        {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+}
+
+void test_cartesian_product()
+{
+    std::vector<std::vector<int>> vs{{0, 1}, {2, 3, 4}, {5, 6}};
+    auto prod = utils::cartesian_product(vs);
+    assert(prod.size() == utils::cartesian_product_count(vs));
+    for (std::size_t r = 0; r < prod.size(); ++r)
+    {
+        auto idx = utils::unrank_cartesian_product(vs, r);
+        for (std::size_t i = 0; i < vs.size(); ++i)
+            assert(vs[i][idx[i]] == prod[r][i]);
+        assert(utils::rank_cartesian_product(vs, idx) == r);
+    }
+
+    std::vector<std::vector<int>> parts;
+    for (std::size_t p = 0; p < 5; ++p)
+    {
+        auto [first, last] = utils::partition_range(prod.size(), 5, p);
+        auto c_part = utils::cartesian_product(vs, first, last);
+        parts.insert(parts.end(), c_part.cbegin(), c_part.cend());
+    }
+    assert(parts == prod);
+}
+
 int main()
 {
     test_literals();
+    test_lbool_vector();
+    test_lit_map();
+    test_watch_lists();
+    test_clause_arena();
 
     test_rationals();
     test_rationals_1();
     test_rationals_2();
+    test_rationals_constexpr();
+    test_rationals_differential();
 
     test_inf_rationals();
 
@@ -308,9 +813,14 @@ int main()
 
     test_tableau();
 
+    test_instrumentation();
+
     test_loss();
 
     test_matrix();
 
+    test_combinations();
+    test_cartesian_product();
+
     return 0;
 }
@@ -0,0 +1,23 @@
+#include "logging.hpp"
+#include <fstream>
+
+int main(int argc, char *argv[])
+{
+    if (argc > 2)
+    {
+        std::cerr << "usage: " << argv[0] << " [binary_log_file]" << std::endl;
+        return 1;
+    }
+
+    if (argc == 2)
+    {
+        std::ifstream in(argv[1], std::ios::binary);
+        if (!in)
+        {
+            std::cerr << "cannot open " << argv[1] << std::endl;
+            return 1;
+        }
+        return utils::decode_binary_log(in, std::cout) ? 0 : 1;
+    }
+    return utils::decode_binary_log(std::cin, std::cout) ? 0 : 1;
+}